@@ -38,6 +38,10 @@
 #include "pipewire/extensions/metadata.h"
 #include "pipewire-jack-extensions.h"
 
+#ifdef HAVE_AUDIOMIXER
+#include "spa/plugins/audiomixer/mix-ops.h"
+#endif
+
 #define JACK_DEFAULT_VIDEO_TYPE	"32 bit float RGBA video"
 
 /* use 512KB stack per thread - the default is way too high to be feasible
@@ -115,10 +119,6 @@ static bool mlock_warned = false;
 #define OBJECT_CHUNK		8
 #define RECYCLE_THRESHOLD	128
 
-typedef void (*mix_func) (float *dst, float *src[], uint32_t n_src, bool aligned, uint32_t n_samples);
-
-static mix_func mix_function;
-
 struct object {
 	struct spa_list link;
 
@@ -379,6 +379,9 @@ struct client {
 
 	struct spa_list mix;
 	struct spa_list free_mix;
+#ifdef HAVE_AUDIOMIXER
+	struct mix_ops mix_ops;
+#endif
 
 	struct spa_list free_ports;
 	struct pw_map ports[2];
@@ -802,43 +805,19 @@ static struct buffer *dequeue_buffer(struct client *c, struct mix *mix)
 	return b;
 }
 
-#if defined (__SSE__)
-#include <xmmintrin.h>
-static void mix_sse(float *dst, float *src[], uint32_t n_src, bool aligned, uint32_t n_samples)
-{
-	uint32_t i, n, unrolled;
-	__m128 in[1];
-
-	if (SPA_IS_ALIGNED(dst, 16) && aligned)
-		unrolled = n_samples & ~3;
-	else
-		unrolled = 0;
-
-	for (n = 0; n < unrolled; n += 4) {
-		in[0] = _mm_load_ps(&src[0][n]);
-		for (i = 1; i < n_src; i++)
-			in[0] = _mm_add_ps(in[0], _mm_load_ps(&src[i][n]));
-		_mm_store_ps(&dst[n], in[0]);
-	}
-	for (; n < n_samples; n++) {
-		in[0] = _mm_load_ss(&src[0][n]);
-		for (i = 1; i < n_src; i++)
-			in[0] = _mm_add_ss(in[0], _mm_load_ss(&src[i][n]));
-		_mm_store_ss(&dst[n], in[0]);
-	}
-}
-#endif
-
-static void mix_c(float *dst, float *src[], uint32_t n_src, bool aligned, uint32_t n_samples)
+#ifndef HAVE_AUDIOMIXER
+static void mix_c(float *dst, const void *src[], uint32_t n_src, uint32_t n_samples)
 {
+	const float **s = (const float **)src;
 	uint32_t n, i;
 	for (n = 0; n < n_samples; n++)  {
-		float t = src[0][n];
+		float t = s[0][n];
 		for (i = 1; i < n_src; i++)
-			t += src[i][n];
+			t += s[i][n];
 		dst[n] = t;
 	}
 }
+#endif
 
 SPA_EXPORT
 void jack_get_version(int *major_ptr, int *minor_ptr, int *micro_ptr, int *proto_ptr)
@@ -3592,10 +3571,12 @@ jack_client_t * jack_client_open (const char *client_name,
                                   jack_status_t *status, ...)
 {
 	struct client *client;
+#ifdef HAVE_AUDIOMIXER
 	const struct spa_support *support;
 	uint32_t n_support;
-	const char *str;
 	struct spa_cpu *cpu_iface;
+#endif
+	const char *str;
 	const struct pw_properties *props;
 	va_list ap;
 
@@ -3679,17 +3660,18 @@ jack_client_t * jack_client_open (const char *client_name,
 	pw_context_conf_section_match_rules(client->context.context, "jack.rules",
 			&props->dict, execute_match, client);
 
+#ifdef HAVE_AUDIOMIXER
 	support = pw_context_get_support(client->context.context, &n_support);
-
-	mix_function = mix_c;
 	cpu_iface = spa_support_find(support, n_support, SPA_TYPE_INTERFACE_CPU);
-	if (cpu_iface) {
-#if defined (__SSE__)
-		uint32_t flags = spa_cpu_get_flags(cpu_iface);
-		if (flags & SPA_CPU_FLAG_SSE)
-			mix_function = mix_sse;
+
+	client->mix_ops.fmt = SPA_AUDIO_FORMAT_F32P;
+	client->mix_ops.n_channels = 1;
+	client->mix_ops.cpu_flags = cpu_iface ? spa_cpu_get_flags(cpu_iface) : 0;
+	if (mix_ops_init(&client->mix_ops) < 0)
+		goto init_failed;
+	pw_log_debug("%p: mixer using cpu flags %08x", client, client->mix_ops.cpu_flags);
 #endif
-	}
+
 	client->context.old_thread_utils =
 		pw_context_get_object(client->context.context,
 				SPA_TYPE_INTERFACE_ThreadUtils);
@@ -3948,6 +3930,11 @@ int jack_client_close (jack_client_t *client)
 		free_object(c, o);
 	recycle_objects(c, 0);
 
+#ifdef HAVE_AUDIOMIXER
+	if (c->mix_ops.free)
+		mix_ops_free(&c->mix_ops);
+#endif
+
 	pw_map_clear(&c->ports[SPA_DIRECTION_INPUT]);
 	pw_map_clear(&c->ports[SPA_DIRECTION_OUTPUT]);
 
@@ -4919,9 +4906,8 @@ static void *get_buffer_input_float(struct port *p, jack_nframes_t frames)
 	struct mix *mix;
 	struct buffer *b;
 	void *ptr = NULL;
-	float *mix_ptr[MAX_MIX], *np;
+	const void *mix_ptr[MAX_MIX];
 	uint32_t n_ptr = 0;
-	bool ptr_aligned = true;
 
 	spa_list_for_each(mix, &p->mix, port_link) {
 		struct spa_data *d;
@@ -4939,19 +4925,19 @@ static void *get_buffer_input_float(struct port *p, jack_nframes_t frames)
 		if (size / sizeof(float) < frames)
 			continue;
 
-		np = SPA_PTROFF(d->data, offset, float);
-		if (!SPA_IS_ALIGNED(np, 16))
-			ptr_aligned = false;
-
-		mix_ptr[n_ptr++] = np;
+		mix_ptr[n_ptr++] = SPA_PTROFF(d->data, offset, void);
 		if (n_ptr == MAX_MIX)
 			break;
 	}
 	if (n_ptr == 1) {
-		ptr = mix_ptr[0];
+		ptr = (void*)mix_ptr[0];
 	} else if (n_ptr > 1) {
 		ptr = p->emptyptr;
-		mix_function(ptr, mix_ptr, n_ptr, ptr_aligned, frames);
+#ifdef HAVE_AUDIOMIXER
+		mix_ops_process(&p->client->mix_ops, ptr, mix_ptr, n_ptr, frames);
+#else
+		mix_c(ptr, mix_ptr, n_ptr, frames);
+#endif
 		p->zeroed = false;
 	}
 	if (ptr == NULL)
@@ -126,27 +126,24 @@ static inline int spa_pod_filter_is_step_of(uint32_t type, const void *r1,
 }
 
 static inline int
-spa_pod_filter_prop(struct spa_pod_builder *b,
-	    const struct spa_pod_prop *p1,
-	    const struct spa_pod_prop *p2)
+spa_pod_filter_prop_values(struct spa_pod_builder *b, uint32_t key, uint32_t flags,
+	    const struct spa_pod *v1, uint32_t nalt1, uint32_t p1c,
+	    const struct spa_pod *v2, uint32_t nalt2, uint32_t p2c)
 {
-	const struct spa_pod *v1, *v2;
 	struct spa_pod_choice *nc;
-	uint32_t j, k, nalt1, nalt2;
+	uint32_t j, k;
 	void *alt1, *alt2, *a1, *a2;
-	uint32_t type, size, p1c, p2c;
+	uint32_t type, size;
 	struct spa_pod_frame f;
 
-	v1 = spa_pod_get_values(&p1->value, &nalt1, &p1c);
 	alt1 = SPA_POD_BODY(v1);
-	v2 = spa_pod_get_values(&p2->value, &nalt2, &p2c);
 	alt2 = SPA_POD_BODY(v2);
 
 	type = v1->type;
 	size = v1->size;
 
 	/* incompatible property types */
-	if (type != v2->type || size != v2->size || p1->key != p2->key)
+	if (type != v2->type || size != v2->size)
 		return -EINVAL;
 
 	if (p1c == SPA_CHOICE_None || p1c == SPA_CHOICE_Flags) {
@@ -164,7 +161,7 @@ spa_pod_filter_prop(struct spa_pod_builder *b,
 	}
 
 	/* start with copying the property */
-	spa_pod_builder_prop(b, p1->key, p1->flags & p2->flags);
+	spa_pod_builder_prop(b, key, flags);
 	spa_pod_builder_push_choice(b, &f, 0, 0);
 	nc = (struct spa_pod_choice*)spa_pod_builder_frame(b, &f);
 
@@ -322,6 +319,24 @@ spa_pod_filter_prop(struct spa_pod_builder *b,
 	return 0;
 }
 
+static inline int
+spa_pod_filter_prop(struct spa_pod_builder *b,
+	    const struct spa_pod_prop *p1,
+	    const struct spa_pod_prop *p2)
+{
+	const struct spa_pod *v1, *v2;
+	uint32_t nalt1, nalt2, p1c, p2c;
+
+	if (p1->key != p2->key)
+		return -EINVAL;
+
+	v1 = spa_pod_get_values(&p1->value, &nalt1, &p1c);
+	v2 = spa_pod_get_values(&p2->value, &nalt2, &p2c);
+
+	return spa_pod_filter_prop_values(b, p1->key, p1->flags & p2->flags,
+			v1, nalt1, p1c, v2, nalt2, p2c);
+}
+
 static inline int spa_pod_filter_part(struct spa_pod_builder *b,
 	       const struct spa_pod *pod, uint32_t pod_size,
 	       const struct spa_pod *filter, uint32_t filter_size)
@@ -450,6 +465,170 @@ spa_pod_filter(struct spa_pod_builder *b,
 	return res;
 }
 
+#define SPA_POD_INDEX_MAX_PROPS	64
+
+/** A decoded property of an indexed object */
+struct spa_pod_index_prop {
+	const struct spa_pod_prop *prop;
+	const struct spa_pod *value;	/**< the values of the property */
+	uint32_t n_values;
+	uint32_t choice;
+};
+
+/**
+ * An object pod with its properties decoded and sorted by key.
+ *
+ * Make an index with spa_pod_index_init() once and filter indexed objects
+ * against each other with spa_pod_filter_index(). The index refers to the
+ * memory of the object, which must stay valid while the index is used.
+ */
+struct spa_pod_index {
+	const struct spa_pod_object *object;
+	uint32_t n_props;
+	struct spa_pod_index_prop props[SPA_POD_INDEX_MAX_PROPS];	/**< in object order */
+	uint8_t sorted[SPA_POD_INDEX_MAX_PROPS];			/**< props sorted by key */
+};
+
+/**
+ * Make an index of an object pod.
+ *
+ * \return 0 on success, -EINVAL when \a pod is not an object and -ENOSPC
+ *   when it has more than SPA_POD_INDEX_MAX_PROPS properties.
+ */
+static inline int
+spa_pod_index_init(struct spa_pod_index *index, const struct spa_pod *pod)
+{
+	const struct spa_pod_object *obj = (const struct spa_pod_object *)pod;
+	const struct spa_pod_prop *p;
+	uint32_t i, j, n = 0;
+
+	if (!spa_pod_is_object(pod))
+		return -EINVAL;
+
+	SPA_POD_OBJECT_FOREACH(obj, p) {
+		struct spa_pod_index_prop *ip;
+
+		if (n == SPA_POD_INDEX_MAX_PROPS)
+			return -ENOSPC;
+
+		ip = &index->props[n];
+		ip->prop = p;
+		ip->value = spa_pod_get_values(&p->value, &ip->n_values, &ip->choice);
+
+		/* insertion sort, properties are mostly sorted already */
+		for (i = n; i > 0; i--) {
+			j = index->sorted[i - 1];
+			if (index->props[j].prop->key <= p->key)
+				break;
+			index->sorted[i] = (uint8_t)j;
+		}
+		index->sorted[i] = (uint8_t)n;
+		n++;
+	}
+	index->object = obj;
+	index->n_props = n;
+	return 0;
+}
+
+/** Find the property with \a key in \a index or NULL */
+static inline const struct spa_pod_index_prop *
+spa_pod_index_find(const struct spa_pod_index *index, uint32_t key)
+{
+	uint32_t lo = 0, hi = index->n_props;
+
+	while (lo < hi) {
+		uint32_t mid = (lo + hi) / 2;
+		const struct spa_pod_index_prop *p = &index->props[index->sorted[mid]];
+
+		if (p->prop->key == key)
+			return p;
+		if (p->prop->key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+
+/**
+ * Filter an indexed object with an indexed filter.
+ *
+ * The result is the same as spa_pod_filter() on the objects but properties
+ * are looked up by key and fixed values that don't match are rejected before
+ * anything is built. When \a filter is NULL, the object is copied.
+ */
+static inline int
+spa_pod_filter_index(struct spa_pod_builder *b,
+	       struct spa_pod **result,
+	       const struct spa_pod_index *pod,
+	       const struct spa_pod_index *filter)
+{
+	const struct spa_pod_index_prop *p1, *p2;
+	struct spa_pod_builder_state state;
+	struct spa_pod_frame f;
+	uint32_t i;
+	int res = 0;
+
+        spa_return_val_if_fail(pod != NULL, -EINVAL);
+        spa_return_val_if_fail(b != NULL, -EINVAL);
+
+	spa_pod_builder_get_state(b, &state);
+
+	if (filter == NULL) {
+		res = spa_pod_builder_raw_padded(b, pod->object, SPA_POD_SIZE(pod->object));
+		goto done;
+	}
+
+	/* reject fixed values that don't match before building anything */
+	for (i = 0; i < pod->n_props; i++) {
+		p1 = &pod->props[i];
+		if (p1->choice != SPA_CHOICE_None ||
+		    (p2 = spa_pod_index_find(filter, p1->prop->key)) == NULL ||
+		    p2->choice != SPA_CHOICE_None)
+			continue;
+		if (p1->value->type != p2->value->type ||
+		    p1->value->size != p2->value->size ||
+		    spa_pod_compare_value(p1->value->type, SPA_POD_BODY_CONST(p1->value),
+				SPA_POD_BODY_CONST(p2->value), p1->value->size) != 0)
+			return -EINVAL;
+	}
+
+	spa_pod_builder_push_object(b, &f, pod->object->body.type, pod->object->body.id);
+	for (i = 0; i < pod->n_props && res >= 0; i++) {
+		p1 = &pod->props[i];
+		p2 = spa_pod_index_find(filter, p1->prop->key);
+		if (p2 != NULL)
+			res = spa_pod_filter_prop_values(b, p1->prop->key,
+					p1->prop->flags & p2->prop->flags,
+					p1->value, p1->n_values, p1->choice,
+					p2->value, p2->n_values, p2->choice);
+		else if ((p1->prop->flags & SPA_POD_PROP_FLAG_MANDATORY) != 0)
+			res = -EINVAL;
+		else
+			spa_pod_builder_raw_padded(b, p1->prop, SPA_POD_PROP_SIZE(p1->prop));
+	}
+	for (i = 0; i < filter->n_props && res >= 0; i++) {
+		p2 = &filter->props[i];
+		if (spa_pod_index_find(pod, p2->prop->key) != NULL)
+			continue;
+		if ((p2->prop->flags & SPA_POD_PROP_FLAG_MANDATORY) != 0)
+			res = -EINVAL;
+		else
+			spa_pod_builder_raw_padded(b, p2->prop, SPA_POD_PROP_SIZE(p2->prop));
+	}
+	spa_pod_builder_pop(b, &f);
+
+done:
+	if (res < 0) {
+		spa_pod_builder_reset(b, &state);
+	} else if (result) {
+		*result = (struct spa_pod*)spa_pod_builder_deref(b, state.offset);
+		if (*result == NULL)
+			res = -ENOSPC;
+	}
+	return res;
+}
+
 /**
  * \}
  */
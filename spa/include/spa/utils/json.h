@@ -17,6 +17,10 @@ extern "C" {
 #include <math.h>
 #include <float.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <spa/utils/defs.h>
 #include <spa/utils/string.h>
 
@@ -53,6 +57,131 @@ static inline void spa_json_enter(struct spa_json * iter, struct spa_json * sub)
 
 #define SPA_JSON_SAVE(iter) ((struct spa_json) { (iter)->cur, (iter)->end, })
 
+/* The scanners below skip over runs of bytes that don't change the state
+ * of the tokenizer, 16 bytes at a time with SSE2 or 8 bytes at a time
+ * with plain 64 bit arithmetic. They return a pointer to the first byte
+ * that needs to go through the state machine or end. */
+#if !defined(__SSE2__)
+static inline uint64_t spa_json_swar_eq(uint64_t v, unsigned char c)
+{
+	v ^= 0x0101010101010101ULL * c;
+	return (v - 0x0101010101010101ULL) & ~v & 0x8080808080808080ULL;
+}
+#endif
+
+static inline bool spa_json_is_space(unsigned char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/* skip whitespace */
+static inline const char *spa_json_scan_space(const char *p, const char *end)
+{
+#if defined(__SSE2__)
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)p);
+		__m128i m = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+					_mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+					_mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+		int mask = ~_mm_movemask_epi8(m) & 0xffff;
+		if (mask)
+			return p + __builtin_ctz(mask);
+	}
+#else
+	for (; end - p >= 8; p += 8) {
+		uint64_t v;
+		memcpy(&v, p, sizeof(v));
+		/* only runs of spaces, the common indentation */
+		if (v != 0x2020202020202020ULL)
+			break;
+	}
+#endif
+	while (p < end && spa_json_is_space(*p))
+		p++;
+	return p;
+}
+
+/* skip until the end of a bare word */
+static inline const char *spa_json_scan_bare(const char *p, const char *end)
+{
+#if defined(__SSE2__)
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)p);
+		__m128i m = _mm_or_si128(
+			_mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+					_mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+					_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')))),
+			_mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')),
+					_mm_cmpeq_epi8(v, _mm_set1_epi8(','))),
+				_mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('=')),
+						_mm_cmpeq_epi8(v, _mm_set1_epi8(']'))),
+					_mm_cmpeq_epi8(v, _mm_set1_epi8('}')))));
+		int mask = _mm_movemask_epi8(m);
+		if (mask)
+			return p + __builtin_ctz(mask);
+	}
+#else
+	for (; end - p >= 8; p += 8) {
+		uint64_t v;
+		memcpy(&v, p, sizeof(v));
+		if (spa_json_swar_eq(v, ' ') | spa_json_swar_eq(v, '\t') |
+		    spa_json_swar_eq(v, '\n') | spa_json_swar_eq(v, '\r') |
+		    spa_json_swar_eq(v, ':') | spa_json_swar_eq(v, ',') |
+		    spa_json_swar_eq(v, '=') | spa_json_swar_eq(v, ']') |
+		    spa_json_swar_eq(v, '}'))
+			break;
+	}
+#endif
+	for (; p < end; p++) {
+		switch (*p) {
+		case '\t': case ' ': case '\r': case '\n':
+		case ':': case ',': case '=': case ']': case '}':
+			return p;
+		}
+	}
+	return p;
+}
+
+/* skip plain printable ASCII characters in a string */
+static inline const char *spa_json_scan_string(const char *p, const char *end)
+{
+#if defined(__SSE2__)
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)p);
+		/* bytes >= 128 are negative and fail the signed compare */
+		__m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(31)),
+				_mm_cmplt_epi8(v, _mm_set1_epi8(127)));
+		__m128i bad = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+		int mask = ~_mm_movemask_epi8(_mm_andnot_si128(bad, ok)) & 0xffff;
+		if (mask)
+			return p + __builtin_ctz(mask);
+	}
+#else
+	for (; end - p >= 8; p += 8) {
+		uint64_t v;
+		memcpy(&v, p, sizeof(v));
+		/* any byte < 32, any byte > 126, '"' or '\\' */
+		if (((v - 0x2020202020202020ULL) & ~v & 0x8080808080808080ULL) |
+		    (((v + 0x0101010101010101ULL) | v) & 0x8080808080808080ULL) |
+		    spa_json_swar_eq(v, '"') | spa_json_swar_eq(v, '\\'))
+			break;
+	}
+#endif
+	for (; p < end; p++) {
+		unsigned char c = (unsigned char)*p;
+		if (c < 32 || c > 126 || c == '"' || c == '\\')
+			break;
+	}
+	return p;
+}
+
 /** Get the next token. \a value points to the token and the return value
  * is the length. */
 static inline int spa_json_next(struct spa_json * iter, const char **value)
@@ -71,7 +200,10 @@ static inline int spa_json_next(struct spa_json * iter, const char **value)
 			goto again;
 		case __STRUCT:
 			switch (cur) {
-			case '\0': case '\t': case ' ': case '\r': case '\n': case ':': case '=': case ',':
+			case '\t': case ' ': case '\r': case '\n':
+				iter->cur = spa_json_scan_space(iter->cur + 1, iter->end) - 1;
+				continue;
+			case '\0': case ':': case '=': case ',':
 				continue;
 			case '#':
 				iter->state = __COMMENT;
@@ -97,6 +229,7 @@ static inline int spa_json_next(struct spa_json * iter, const char **value)
 			default:
 				*value = iter->cur;
 				iter->state = __BARE;
+				iter->cur = spa_json_scan_bare(iter->cur + 1, iter->end) - 1;
 			}
 			continue;
 		case __BARE:
@@ -130,8 +263,10 @@ static inline int spa_json_next(struct spa_json * iter, const char **value)
 				iter->state = __UTF8;
 				continue;
 			default:
-				if (cur >= 32 && cur <= 126)
+				if (cur >= 32 && cur <= 126) {
+					iter->cur = spa_json_scan_string(iter->cur + 1, iter->end) - 1;
 					continue;
+				}
 			}
 			return -1;
 		case __UTF8:
@@ -217,9 +352,76 @@ static inline bool spa_json_is_null(const char *val, int len)
 }
 
 /* float */
+/* Parse plain decimal numbers with at most 15 significant digits and a
+ * small exponent. The mantissa and the power of 10 are then exact doubles
+ * so the multiply or divide is correctly rounded. Returns false when the
+ * number needs the slow path. */
+static inline bool spa_json_parse_float_fast(const char *val, int len, float *result)
+{
+	static const double p10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	const char *p = val, *end = val + len;
+	uint64_t mant = 0, bits;
+	int n_digits = 0, n_sig = 0, exp = 0, e = 0;
+	bool neg = false, eneg = false;
+	double d;
+
+	if (p < end && (*p == '-' || *p == '+'))
+		neg = *p++ == '-';
+	for (; p < end && *p >= '0' && *p <= '9'; p++, n_digits++) {
+		if (mant != 0 || *p != '0')
+			n_sig++;
+		mant = mant * 10 + (*p - '0');
+		if (n_sig > 15)
+			return false;
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++, n_digits++) {
+			if (mant != 0 || *p != '0')
+				n_sig++;
+			mant = mant * 10 + (*p - '0');
+			if (n_sig > 15)
+				return false;
+			exp--;
+		}
+	}
+	if (n_digits == 0)
+		return false;
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		if (++p < end && (*p == '-' || *p == '+'))
+			eneg = *p++ == '-';
+		if (p == end)
+			return false;
+		for (; p < end && *p >= '0' && *p <= '9'; p++) {
+			e = e * 10 + (*p - '0');
+			if (e > 100)
+				return false;
+		}
+		exp += eneg ? -e : e;
+	}
+	if (p != end || exp < -22 || exp > 22)
+		return false;
+
+	d = (double)mant;
+	d = exp < 0 ? d / p10[-exp] : d * p10[exp];
+
+	/* converting to float rounds a second time, this can only go wrong
+	 * when the double is exactly halfway between two floats */
+	memcpy(&bits, &d, sizeof(bits));
+	if ((bits & 0x1fffffffULL) == 0x10000000ULL)
+		return false;
+
+	*result = (float)(neg ? -d : d);
+	return true;
+}
+
 static inline int spa_json_parse_float(const char *val, int len, float *result)
 {
 	char *end;
+	if (len > 0 && spa_json_parse_float_fast(val, len, result))
+		return 1;
 	if (strspn(val, "+-0123456789.Ee") < (size_t)len)
 		return 0;
 	*result = spa_strtof(val, &end);
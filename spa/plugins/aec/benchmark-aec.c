@@ -0,0 +1,481 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include "config.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <getopt.h>
+
+#include <spa/support/log-impl.h>
+#include <spa/interfaces/audio/aec.h>
+#include <spa/utils/string.h>
+#include <spa/utils/result.h>
+
+SPA_LOG_IMPL(logger);
+
+#include "test-helper.h"
+#include "wavfile.h"
+
+#define DEFAULT_LIB		"aec/libspa-aec-null.so"
+#define DEFAULT_RATE		48000u
+#define DEFAULT_CHANNELS	1u
+#define DEFAULT_BLOCKSIZE	480u
+#define DEFAULT_SECONDS		10u
+
+#define MAX_BLOCKSIZE		8192u
+#define MAX_ARGS		16u
+
+/* the synthetic echo path: a delayed and attenuated copy of the far end */
+#define ECHO_DELAY		240u
+#define ECHO_GAIN		0.5f
+#define NEAR_GAIN		0.01f
+
+struct data {
+	const char *lib;
+	uint32_t rate;
+	uint32_t channels;
+	uint32_t blocksize;
+	uint32_t seconds;
+	bool verbose;
+
+	struct spa_dict_item items[MAX_ARGS];
+	struct spa_dict args;
+
+	const char *play_name;
+	const char *rec_name;
+	const char *out_name;
+	struct wav_file *play_file;
+	struct wav_file *rec_file;
+	struct wav_file *out_file;
+	uint32_t play_format;
+	uint32_t rec_format;
+
+	struct spa_handle *handle;
+	struct spa_audio_aec *aec;
+
+	float *play[SPA_AUDIO_MAX_CHANNELS];
+	float *rec[SPA_AUDIO_MAX_CHANNELS];
+	float *out[SPA_AUDIO_MAX_CHANNELS];
+	float *history[SPA_AUDIO_MAX_CHANNELS];
+	float *buffer;
+	float *interleaved;
+
+	uint64_t n_samples;
+	uint64_t n_blocks;
+	uint64_t total_ns;
+	uint64_t worst_ns;
+	double rec_energy[2];
+	double out_energy[2];
+};
+
+#define OPTIONS		"hvl:a:r:c:b:s:p:m:o:"
+static const struct option long_options[] = {
+	{ "help",	no_argument,		NULL, 'h'},
+	{ "verbose",	no_argument,		NULL, 'v'},
+
+	{ "library",	required_argument,	NULL, 'l' },
+	{ "arg",	required_argument,	NULL, 'a' },
+	{ "rate",	required_argument,	NULL, 'r' },
+	{ "channels",	required_argument,	NULL, 'c' },
+	{ "blocksize",	required_argument,	NULL, 'b' },
+	{ "seconds",	required_argument,	NULL, 's' },
+	{ "play",	required_argument,	NULL, 'p' },
+	{ "rec",	required_argument,	NULL, 'm' },
+	{ "out",	required_argument,	NULL, 'o' },
+
+	{ NULL, 0, NULL, 0 }
+};
+
+static void show_usage(const char *name, bool is_error)
+{
+	FILE *fp;
+
+	fp = is_error ? stderr : stdout;
+
+	fprintf(fp, "%s [options]\n", name);
+	fprintf(fp,
+		"  -h, --help                            Show this help\n"
+		"  -v, --verbose                         Be verbose\n"
+		"\n");
+	fprintf(fp,
+		"  -l  --library                         AEC library relative to SPA_PLUGIN_DIR\n"
+		"                                        (default "DEFAULT_LIB")\n"
+		"  -a  --arg                             key=value argument for the AEC, can be\n"
+		"                                        repeated\n"
+		"  -r  --rate                            Sample rate (default %u)\n"
+		"  -c  --channels                        Channels (default %u)\n"
+		"  -b  --blocksize                       Samples per block (default %u)\n"
+		"  -s  --seconds                         Length of the generated signals\n"
+		"                                        (default %u)\n"
+		"  -p  --play                            Far end (playback) WAV file\n"
+		"  -m  --rec                             Near end (capture) WAV file\n"
+		"  -o  --out                             Write the cancelled capture to a\n"
+		"                                        WAV file\n"
+		"\n"
+		"Without --play and --rec a far end noise signal and its echo are\n"
+		"generated.\n",
+		DEFAULT_RATE, DEFAULT_CHANNELS, DEFAULT_BLOCKSIZE, DEFAULT_SECONDS);
+}
+
+static int add_arg(struct data *d, char *arg)
+{
+	char *val;
+
+	if (d->args.n_items >= MAX_ARGS)
+		return -ENOSPC;
+	if ((val = strchr(arg, '=')) == NULL)
+		return -EINVAL;
+	*val++ = '\0';
+	d->items[d->args.n_items++] = SPA_DICT_ITEM_INIT(arg, val);
+	return 0;
+}
+
+static struct wav_file *open_input(struct data *d, const char *name, uint32_t *format)
+{
+	struct wav_file_info info;
+	struct wav_file *wf;
+
+	spa_zero(info);
+	if ((wf = wav_file_open(name, "r", &info)) == NULL) {
+		fprintf(stderr, "can't open %s: %m\n", name);
+		return NULL;
+	}
+	if (info.info.info.raw.format != SPA_AUDIO_FORMAT_S16_LE &&
+	    info.info.info.raw.format != SPA_AUDIO_FORMAT_F32_LE) {
+		fprintf(stderr, "%s: only S16 and F32 WAV files are supported\n", name);
+		goto error;
+	}
+	if (d->play_file == NULL && d->rec_file == NULL) {
+		d->rate = info.info.info.raw.rate;
+		d->channels = info.info.info.raw.channels;
+	} else if (d->rate != info.info.info.raw.rate ||
+	    d->channels != info.info.info.raw.channels) {
+		fprintf(stderr, "%s: rate and channels of the files don't match\n", name);
+		goto error;
+	}
+	*format = info.info.info.raw.format;
+	return wf;
+error:
+	wav_file_close(wf);
+	errno = EINVAL;
+	return NULL;
+}
+
+static uint32_t read_input(struct data *d, struct wav_file *wf, uint32_t format,
+		float **dst, uint32_t n_samples)
+{
+	ssize_t n;
+	uint32_t i, j, c = d->channels;
+
+	if ((n = wav_file_read(wf, d->interleaved, n_samples)) <= 0)
+		return 0;
+
+	if (format == SPA_AUDIO_FORMAT_S16_LE) {
+		const int16_t *s = (const int16_t *)d->interleaved;
+		for (i = 0; i < (uint32_t)n; i++)
+			for (j = 0; j < c; j++)
+				dst[j][i] = s[i * c + j] / 32768.0f;
+	} else {
+		const float *s = d->interleaved;
+		for (i = 0; i < (uint32_t)n; i++)
+			for (j = 0; j < c; j++)
+				dst[j][i] = s[i * c + j];
+	}
+	return n;
+}
+
+static uint32_t generate_input(struct data *d, uint32_t n_samples)
+{
+	uint64_t total = (uint64_t)d->seconds * d->rate;
+	uint32_t i, j;
+
+	n_samples = SPA_MIN(n_samples, total - SPA_MIN(d->n_samples, total));
+
+	for (j = 0; j < d->channels; j++) {
+		float *h = d->history[j];
+
+		/* the history starts with the last ECHO_DELAY far end samples
+		 * of the previous block */
+		for (i = 0; i < n_samples; i++) {
+			h[ECHO_DELAY + i] = d->play[j][i] = (float)(drand48() * 2.0 - 1.0) * 0.5f;
+			d->rec[j][i] = h[i] * ECHO_GAIN +
+				(float)(drand48() * 2.0 - 1.0) * NEAR_GAIN;
+		}
+		memmove(h, &h[n_samples], ECHO_DELAY * sizeof(float));
+	}
+	return n_samples;
+}
+
+static int write_output(struct data *d, uint32_t n_samples)
+{
+	const void *data[SPA_AUDIO_MAX_CHANNELS];
+	uint32_t i;
+
+	for (i = 0; i < d->channels; i++)
+		data[i] = d->out[i];
+	return wav_file_write(d->out_file, data, n_samples);
+}
+
+static void measure(struct data *d, uint32_t n_samples)
+{
+	/* the second set of energies skips the first two seconds so that
+	 * it reports the attenuation of the converged canceller */
+	uint32_t idx = d->n_samples >= (uint64_t)d->rate * 2 ? 1 : 0;
+	uint32_t i, j;
+
+	for (j = 0; j < d->channels; j++) {
+		double er = 0.0, eo = 0.0;
+		for (i = 0; i < n_samples; i++) {
+			er += d->rec[j][i] * d->rec[j][i];
+			eo += d->out[j][i] * d->out[j][i];
+		}
+		d->rec_energy[0] += er;
+		d->out_energy[0] += eo;
+		if (idx) {
+			d->rec_energy[1] += er;
+			d->out_energy[1] += eo;
+		}
+	}
+}
+
+static double erle(double rec, double out)
+{
+	return 10.0 * log10(SPA_MAX(rec, 1e-20) / SPA_MAX(out, 1e-20));
+}
+
+static int process(struct data *d)
+{
+	struct timespec ts;
+	uint64_t t1, t2;
+	uint32_t n, n_play;
+	int res;
+
+	while (true) {
+		if (d->rec_file) {
+			n = read_input(d, d->rec_file, d->rec_format, d->rec, d->blocksize);
+			if (n == 0)
+				break;
+			n_play = d->play_file ?
+				read_input(d, d->play_file, d->play_format, d->play, n) : 0;
+			/* pad a short far end with silence */
+			for (uint32_t j = 0; j < d->channels; j++)
+				memset(&d->play[j][n_play], 0, (n - n_play) * sizeof(float));
+		} else {
+			n = generate_input(d, d->blocksize);
+			if (n == 0)
+				break;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		t1 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+		res = spa_audio_aec_run(d->aec, (const float **)d->rec,
+				(const float **)d->play, d->out, n);
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		t2 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+		if (res < 0) {
+			fprintf(stderr, "aec run failed: %s\n", spa_strerror(res));
+			return res;
+		}
+
+		d->total_ns += t2 - t1;
+		d->worst_ns = SPA_MAX(d->worst_ns, t2 - t1);
+		d->n_blocks++;
+
+		measure(d, n);
+		d->n_samples += n;
+
+		if (d->out_file && (res = write_output(d, n)) < 0) {
+			fprintf(stderr, "write failed: %s\n", spa_strerror(res));
+			return res;
+		}
+	}
+	return 0;
+}
+
+static void report(struct data *d)
+{
+	double duration = (double)d->n_samples / d->rate;
+	double block_ns = (double)d->blocksize * SPA_NSEC_PER_SEC / d->rate;
+
+	if (d->n_blocks == 0) {
+		fprintf(stderr, "no samples processed\n");
+		return;
+	}
+
+	fprintf(stdout, "%s: rate %u, channels %u, blocksize %u, %.2f seconds\n",
+			d->lib, d->rate, d->channels, d->blocksize, duration);
+	fprintf(stdout, "  real time factor      %.6f\n",
+			d->total_ns / (duration * SPA_NSEC_PER_SEC));
+	fprintf(stdout, "  block mean            %.1f us (%.2f%% of a block)\n",
+			(double)d->total_ns / d->n_blocks / 1000.0,
+			(double)d->total_ns / d->n_blocks * 100.0 / block_ns);
+	fprintf(stdout, "  block worst           %.1f us (%.2f%% of a block)\n",
+			d->worst_ns / 1000.0, d->worst_ns * 100.0 / block_ns);
+	fprintf(stdout, "  ERLE                  %.2f dB\n",
+			erle(d->rec_energy[0], d->out_energy[0]));
+	if (d->rec_energy[1] > 0.0)
+		fprintf(stdout, "  ERLE after 2 seconds  %.2f dB\n",
+				erle(d->rec_energy[1], d->out_energy[1]));
+}
+
+int main(int argc, char *argv[])
+{
+	struct data data;
+	struct spa_support support[1];
+	struct spa_audio_info_raw info;
+	void *iface;
+	uint32_t i, n_buffers;
+	int c, res;
+
+	spa_zero(data);
+	data.lib = DEFAULT_LIB;
+	data.rate = DEFAULT_RATE;
+	data.channels = DEFAULT_CHANNELS;
+	data.blocksize = DEFAULT_BLOCKSIZE;
+	data.seconds = DEFAULT_SECONDS;
+	data.args = SPA_DICT_INIT(data.items, 0);
+
+	while ((c = getopt_long(argc, argv, OPTIONS, long_options, NULL)) != -1) {
+		switch (c) {
+		case 'h':
+			show_usage(argv[0], false);
+			return EXIT_SUCCESS;
+		case 'v':
+			data.verbose = true;
+			break;
+		case 'l':
+			data.lib = optarg;
+			break;
+		case 'a':
+			if (add_arg(&data, optarg) < 0) {
+				fprintf(stderr, "invalid argument %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'r':
+			data.rate = atoi(optarg);
+			break;
+		case 'c':
+			data.channels = atoi(optarg);
+			break;
+		case 'b':
+			data.blocksize = atoi(optarg);
+			break;
+		case 's':
+			data.seconds = atoi(optarg);
+			break;
+		case 'p':
+			data.play_name = optarg;
+			break;
+		case 'm':
+			data.rec_name = optarg;
+			break;
+		case 'o':
+			data.out_name = optarg;
+			break;
+		default:
+			show_usage(argv[0], true);
+			return EXIT_FAILURE;
+		}
+	}
+	if (data.play_name != NULL && data.rec_name == NULL) {
+		fprintf(stderr, "a far end file needs a near end file\n");
+		return EXIT_FAILURE;
+	}
+
+	if (data.rec_name &&
+	    (data.rec_file = open_input(&data, data.rec_name, &data.rec_format)) == NULL)
+		return EXIT_FAILURE;
+	if (data.play_name &&
+	    (data.play_file = open_input(&data, data.play_name, &data.play_format)) == NULL)
+		return EXIT_FAILURE;
+
+	if (data.rate == 0 || data.channels == 0 || data.channels > SPA_AUDIO_MAX_CHANNELS ||
+	    data.blocksize == 0 || data.blocksize > MAX_BLOCKSIZE) {
+		fprintf(stderr, "invalid rate, channels or blocksize\n");
+		return EXIT_FAILURE;
+	}
+
+	/* play, rec, out and history for each channel, history holds the
+	 * delayed far end in front of the current block */
+	n_buffers = 4 * data.channels;
+	data.buffer = calloc(n_buffers * (data.blocksize + ECHO_DELAY), sizeof(float));
+	data.interleaved = calloc(data.blocksize * data.channels, sizeof(float));
+	if (data.buffer == NULL || data.interleaved == NULL)
+		return EXIT_FAILURE;
+	for (i = 0; i < data.channels; i++) {
+		float *p = &data.buffer[i * 4 * (data.blocksize + ECHO_DELAY)];
+		data.play[i] = p;
+		data.rec[i] = p + (data.blocksize + ECHO_DELAY);
+		data.out[i] = p + 2 * (data.blocksize + ECHO_DELAY);
+		data.history[i] = p + 3 * (data.blocksize + ECHO_DELAY);
+	}
+
+	logger.log.level = data.verbose ? SPA_LOG_LEVEL_INFO : SPA_LOG_LEVEL_WARN;
+	support[0] = SPA_SUPPORT_INIT(SPA_TYPE_INTERFACE_Log, &logger);
+
+	if ((data.handle = load_handle(support, 1, data.lib, SPA_NAME_AEC)) == NULL) {
+		fprintf(stderr, "can't load %s: %m\n", data.lib);
+		return EXIT_FAILURE;
+	}
+	if ((res = spa_handle_get_interface(data.handle, SPA_TYPE_INTERFACE_AUDIO_AEC, &iface)) < 0) {
+		fprintf(stderr, "can't get AEC interface: %s\n", spa_strerror(res));
+		return EXIT_FAILURE;
+	}
+	data.aec = iface;
+
+	spa_zero(info);
+	info.format = SPA_AUDIO_FORMAT_F32P;
+	info.rate = data.rate;
+	info.channels = data.channels;
+	if ((res = spa_audio_aec_init(data.aec, &data.args, &info)) < 0) {
+		fprintf(stderr, "can't init AEC: %s\n", spa_strerror(res));
+		return EXIT_FAILURE;
+	}
+	spa_audio_aec_activate(data.aec);
+
+	if (data.out_name) {
+		struct wav_file_info oinfo;
+
+		spa_zero(oinfo);
+		oinfo.info.media_type = SPA_MEDIA_TYPE_audio;
+		oinfo.info.media_subtype = SPA_MEDIA_SUBTYPE_raw;
+		oinfo.info.info.raw = info;
+		if ((data.out_file = wav_file_open(data.out_name, "w", &oinfo)) == NULL) {
+			fprintf(stderr, "can't open %s: %m\n", data.out_name);
+			return EXIT_FAILURE;
+		}
+	}
+
+	srand48(0);
+	res = process(&data);
+
+	spa_audio_aec_deactivate(data.aec);
+
+	if (res >= 0)
+		report(&data);
+
+	if (data.out_file)
+		wav_file_close(data.out_file);
+	if (data.play_file)
+		wav_file_close(data.play_file);
+	if (data.rec_file)
+		wav_file_close(data.rec_file);
+
+	spa_handle_clear(data.handle);
+	free(data.handle);
+	free(data.buffer);
+	free(data.interleaved);
+
+	return res < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
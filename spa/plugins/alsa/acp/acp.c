@@ -6,6 +6,10 @@
 #include "alsa-mixer.h"
 #include "alsa-ucm.h"
 
+#include <limits.h>
+#include <sys/stat.h>
+#include <time.h>
+
 #include <spa/utils/string.h>
 
 int _acp_log_level = 1;
@@ -1528,6 +1532,265 @@ static void prune_singleton_availability_groups(pa_hashmap *ports) {
     pa_hashmap_free(group_counts);
 }
 
+#define PROBE_CACHE_VERSION	"2"
+#define PROBE_CACHE_TTL		(7 * 24 * 60 * 60)
+
+static uint64_t hash_string(uint64_t h, const char *str)
+{
+	/* FNV-1a, with a separator so that "ab","c" != "a","bc" */
+	while (str && *str) {
+		h ^= (uint8_t)*str++;
+		h *= 0x100000001b3ULL;
+	}
+	h ^= 0xff;
+	h *= 0x100000001b3ULL;
+	return h;
+}
+
+/* The probe results depend on the card hardware and driver and on the
+ * profiles and mappings we get from the profile-set or UCM configuration.
+ * Hash all of these so that the cache is invalidated when any of them
+ * changes. With UCM the profiles are the verbs and the mappings are named
+ * after the UCM devices and modifiers. */
+static uint64_t probe_cache_key(pa_card *impl)
+{
+	snd_ctl_t *ctl;
+	snd_ctl_card_info_t *info;
+	pa_alsa_profile *p;
+	pa_alsa_mapping *m;
+	uint64_t h = 0xcbf29ce484222325ULL;
+	char name[64], buf[32];
+	uint32_t idx;
+	void *state;
+	char **d;
+
+	snprintf(name, sizeof(name), "hw:%u", impl->card.index);
+	if (snd_ctl_open(&ctl, name, 0) < 0)
+		return 0;
+
+	snd_ctl_card_info_alloca(&info);
+	if (snd_ctl_card_info(ctl, info) < 0) {
+		snd_ctl_close(ctl);
+		return 0;
+	}
+	h = hash_string(h, snd_ctl_card_info_get_driver(info));
+	h = hash_string(h, snd_ctl_card_info_get_components(info));
+	h = hash_string(h, snd_ctl_card_info_get_longname(info));
+	h = hash_string(h, snd_ctl_card_info_get_mixername(info));
+	snd_ctl_close(ctl);
+
+	snprintf(buf, sizeof(buf), "%d:%u:%u", impl->use_ucm, impl->rate, impl->pro_channels);
+	h = hash_string(h, buf);
+
+	PA_HASHMAP_FOREACH(p, impl->profile_set->profiles, state) {
+		h = hash_string(h, p->name);
+		if (p->output_mappings)
+			PA_IDXSET_FOREACH(m, p->output_mappings, idx) {
+				h = hash_string(h, m->name);
+				for (d = m->device_strings; d && *d; d++)
+					h = hash_string(h, *d);
+			}
+		if (p->input_mappings)
+			PA_IDXSET_FOREACH(m, p->input_mappings, idx) {
+				h = hash_string(h, m->name);
+				for (d = m->device_strings; d && *d; d++)
+					h = hash_string(h, *d);
+			}
+	}
+	return h;
+}
+
+static int probe_cache_path(pa_card *impl, char *path, size_t size)
+{
+	const char *dir;
+	uint64_t key;
+	int len;
+
+	if ((key = probe_cache_key(impl)) == 0)
+		return -ENOENT;
+
+	if ((dir = getenv("XDG_CACHE_HOME")) != NULL)
+		len = snprintf(path, size, "%s/pipewire", dir);
+	else if ((dir = getenv("HOME")) != NULL)
+		len = snprintf(path, size, "%s/.cache/pipewire", dir);
+	else
+		return -ENOENT;
+
+	if (len < 0 || (size_t)len >= size)
+		return -ENAMETOOLONG;
+
+	if (snprintf(path + len, size - len, "/acp-%016"PRIx64".cache", key) >= (int)(size - len))
+		return -ENAMETOOLONG;
+
+	return 0;
+}
+
+/* Read the cache and mark the profiles that were found unsupported. A cache
+ * that is older than PROBE_CACHE_TTL is ignored so that a profile that is
+ * cached as unsupported is probed again from time to time. The contents
+ * after the header are returned in body to detect changes. */
+static bool probe_cache_load(pa_card *impl, const char *path, time_t now,
+		time_t *created, char **body)
+{
+	pa_alsa_profile *p;
+	char line[1024];
+	bool valid = false;
+	long long t;
+	size_t size;
+	FILE *f, *b;
+
+	if ((f = fopen(path, "re")) == NULL)
+		return false;
+
+	if (fgets(line, sizeof(line), f) == NULL ||
+	    sscanf(line, "# acp probe cache " PROBE_CACHE_VERSION " %lld", &t) != 1) {
+		pa_log_info("Ignoring probe cache %s with unknown version", path);
+		goto done;
+	}
+	if (t > now || now - t > PROBE_CACHE_TTL) {
+		pa_log_info("Probe cache %s expired", path);
+		goto done;
+	}
+	if ((b = open_memstream(body, &size)) == NULL)
+		goto done;
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		fputs(line, b);
+		line[strcspn(line, "\n")] = '\0';
+
+		if (spa_strstartswith(line, "unsupported ") &&
+		    (p = pa_hashmap_get(impl->profile_set->profiles, line + 12)) != NULL)
+			p->cached_unsupported = true;
+	}
+	fclose(b);
+	*created = (time_t)t;
+	valid = true;
+done:
+	fclose(f);
+	return valid;
+}
+
+/* Profiles that could not be opened because the device was busy are not
+ * stored, they are probed again the next time. */
+static char *probe_cache_format(pa_card *impl, char **names, pa_hashmap *busy)
+{
+	pa_alsa_profile *p;
+	char *body = NULL;
+	size_t size;
+	FILE *f;
+
+	if ((f = open_memstream(&body, &size)) == NULL)
+		return NULL;
+
+	for (; *names; names++) {
+		if (pa_hashmap_get(busy, *names) != NULL)
+			continue;
+		p = pa_hashmap_get(impl->profile_set->profiles, *names);
+		fprintf(f, "%s %s\n", p && p->supported ? "supported" : "unsupported", *names);
+	}
+	if (fclose(f) != 0) {
+		free(body);
+		return NULL;
+	}
+	return body;
+}
+
+static void probe_cache_save(pa_card *impl, const char *path, time_t created,
+		const char *body)
+{
+	char tmp[PATH_MAX], *dir;
+	FILE *f;
+	int fd;
+
+	/* make sure XDG_CACHE_HOME and the pipewire dir below it exist */
+	spa_scnprintf(tmp, sizeof(tmp), "%s", path);
+	if ((dir = strrchr(tmp, '/')) == NULL)
+		return;
+	*dir = '\0';
+	if ((dir = strrchr(tmp, '/')) != NULL) {
+		*dir = '\0';
+		mkdir(tmp, 0700);
+		*dir = '/';
+	}
+	if (mkdir(tmp, 0700) < 0 && errno != EEXIST)
+		goto error;
+
+	if (spa_scnprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >= (int)sizeof(tmp) - 1)
+		return;
+	if ((fd = mkstemp(tmp)) < 0)
+		goto error;
+	if ((f = fdopen(fd, "w")) == NULL) {
+		close(fd);
+		unlink(tmp);
+		goto error;
+	}
+
+	fprintf(f, "# acp probe cache " PROBE_CACHE_VERSION " %lld\n", (long long)created);
+	fputs(body, f);
+	if (fclose(f) != 0 || rename(tmp, path) < 0) {
+		unlink(tmp);
+		goto error;
+	}
+	pa_log_info("Saved probe results in %s", path);
+	return;
+error:
+	pa_log_warn("Can't save probe cache %s: %m", path);
+}
+
+static void profile_set_probe(pa_card *impl, const char *device_id)
+{
+	char path[PATH_MAX], **names = NULL, *old_body = NULL, *body;
+	pa_alsa_profile *p;
+	pa_hashmap *busy = NULL;
+	time_t now = time(NULL), created = now;
+	bool cached = false;
+	void *state;
+	uint32_t n;
+
+	if (impl->probe_cache && probe_cache_path(impl, path, sizeof(path)) == 0) {
+		/* remember all profile names, the unsupported ones are removed
+		 * from the profile set while probing */
+		names = pa_xnew0(char *, pa_hashmap_size(impl->profile_set->profiles) + 1);
+		n = 0;
+		PA_HASHMAP_FOREACH(p, impl->profile_set->profiles, state)
+			names[n++] = pa_xstrdup(p->name);
+
+		cached = probe_cache_load(impl, path, now, &created, &old_body);
+		pa_log_info("Probe cache %s %s", path, cached ? "hit" : "miss");
+
+		busy = pa_hashmap_new_full(pa_idxset_string_hash_func,
+				pa_idxset_string_compare_func, pa_xfree, NULL);
+		impl->profile_set->busy_profiles = busy;
+	}
+
+	if (impl->use_ucm)
+		pa_alsa_ucm_probe_profile_set(&impl->ucm, impl->profile_set);
+	else
+		pa_alsa_profile_set_probe(impl->profile_set, impl->ucm.mixers,
+				device_id,
+				&impl->ucm.default_sample_spec,
+				impl->ucm.default_n_fragments,
+				impl->ucm.default_fragment_size_msec);
+
+	if (names != NULL) {
+		impl->profile_set->busy_profiles = NULL;
+
+		/* a hit is only written again when the results changed, a
+		 * profile that was busy before or that failed now. The time of
+		 * the first probe is kept so that the cache still expires. */
+		body = probe_cache_format(impl, names, busy);
+		if (body != NULL && !spa_streq(body, old_body))
+			probe_cache_save(impl, path, created, body);
+
+		free(body);
+		free(old_body);
+		pa_hashmap_free(busy);
+		for (n = 0; names[n]; n++)
+			pa_xfree(names[n]);
+		pa_xfree(names);
+	}
+}
+
 static const char *acp_dict_lookup(const struct acp_dict *dict, const char *key)
 {
 	const struct acp_dict_item *it;
@@ -1587,6 +1850,8 @@ struct acp_card *acp_card_new(uint32_t index, const struct acp_dict *props)
 			impl->rate = atoi(s);
 		if ((s = acp_dict_lookup(props, "api.acp.pro-channels")) != NULL)
 			impl->pro_channels = atoi(s);
+		if ((s = acp_dict_lookup(props, "api.acp.probe-cache")) != NULL)
+			impl->probe_cache = spa_atob(s);
 	}
 
 	impl->ucm.default_sample_spec.format = PA_SAMPLE_S16NE;
@@ -1628,11 +1893,7 @@ struct acp_card *acp_card_new(uint32_t index, const struct acp_dict *props)
 
 	impl->profile_set->ignore_dB = impl->ignore_dB;
 
-	pa_alsa_profile_set_probe(impl->profile_set, impl->ucm.mixers,
-			device_id,
-			&impl->ucm.default_sample_spec,
-			impl->ucm.default_n_fragments,
-			impl->ucm.default_fragment_size_msec);
+	profile_set_probe(impl, device_id);
 
 	pa_alsa_init_proplist_card(NULL, impl->proplist, impl->card.index);
 	pa_proplist_sets(impl->proplist, PA_PROP_DEVICE_STRING, device_id);
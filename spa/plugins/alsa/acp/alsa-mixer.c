@@ -5112,6 +5112,12 @@ void pa_alsa_profile_set_probe(
             if (selected_fallback_output == NULL || pa_idxset_get_by_index(p->output_mappings, 0) != selected_fallback_output)
                 continue;
 
+        /* Skip if an earlier probe of the same card found this profile unsupported */
+        if (p->cached_unsupported && !p->supported) {
+            pa_log_debug("Skipping profile %s - cached as unsupported", p->name);
+            continue;
+        }
+
         /* Skip if this is already marked that it is supported (i.e. from the config file) */
         if (!p->supported) {
 
@@ -5154,7 +5160,10 @@ void pa_alsa_profile_set_probe(
                                                            default_n_fragments,
                                                            default_fragment_size_msec))) {
                         p->supported = false;
-                        if (pa_idxset_size(p->output_mappings) == 1 &&
+                        if (errno == EBUSY || errno == EAGAIN) {
+                            pa_log_debug("Output:%s is busy", m->name);
+                            p->probe_busy = true;
+                        } else if (pa_idxset_size(p->output_mappings) == 1 &&
                             ((!p->input_mappings) || pa_idxset_size(p->input_mappings) == 0)) {
                             pa_log_debug("Caching failure to open output:%s", m->name);
                             pa_hashmap_put(broken_outputs, m, m);
@@ -5178,7 +5187,10 @@ void pa_alsa_profile_set_probe(
                                                           default_n_fragments,
                                                           default_fragment_size_msec))) {
                         p->supported = false;
-                        if (pa_idxset_size(p->input_mappings) == 1 &&
+                        if (errno == EBUSY || errno == EAGAIN) {
+                            pa_log_debug("Input:%s is busy", m->name);
+                            p->probe_busy = true;
+                        } else if (pa_idxset_size(p->input_mappings) == 1 &&
                             ((!p->output_mappings) || pa_idxset_size(p->output_mappings) == 0)) {
                             pa_log_debug("Caching failure to open input:%s", m->name);
                             pa_hashmap_put(broken_inputs, m, m);
@@ -5269,6 +5281,10 @@ void pa_alsa_profile_set_drop_unsupported(pa_alsa_profile_set *ps) {
     void *state;
 
     PA_HASHMAP_FOREACH(p, ps->profiles, state) {
+        if (!p->supported && p->probe_busy && ps->busy_profiles) {
+            char *name = pa_xstrdup(p->name);
+            pa_hashmap_put(ps->busy_profiles, name, name);
+        }
         if (!p->supported)
             pa_hashmap_remove_and_free(ps->profiles, p->name);
     }
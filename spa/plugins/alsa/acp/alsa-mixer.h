@@ -374,6 +374,8 @@ struct pa_alsa_profile {
     bool supported:1;
     bool fallback_input:1;
     bool fallback_output:1;
+    bool cached_unsupported:1;
+    bool probe_busy:1;
 
     char **input_mapping_names;
     char **output_mapping_names;
@@ -412,6 +414,10 @@ struct pa_alsa_profile_set {
     pa_hashmap *input_paths;
     pa_hashmap *output_paths;
 
+    /* when set, filled with the names of the profiles that could not be
+     * probed because a device was busy */
+    pa_hashmap *busy_profiles;
+
     bool auto_profiles;
     bool ignore_dB:1;
     bool probed:1;
@@ -2015,13 +2015,23 @@ static void ucm_mapping_jack_probe(pa_alsa_mapping *m, pa_hashmap *mixers) {
     }
 }
 
-static void ucm_probe_profile_set(pa_alsa_ucm_config *ucm, pa_alsa_profile_set *ps) {
+void pa_alsa_ucm_probe_profile_set(pa_alsa_ucm_config *ucm, pa_alsa_profile_set *ps) {
     void *state;
     pa_alsa_profile *p;
     pa_alsa_mapping *m;
     uint32_t idx;
 
+    if (ps->probed)
+        return;
+
     PA_HASHMAP_FOREACH(p, ps->profiles, state) {
+        /* Skip if an earlier probe of the same card found this verb unsupported */
+        if (p->cached_unsupported) {
+            pa_log_debug("Skipping profile %s - cached as unsupported", p->name);
+            p->supported = false;
+            continue;
+        }
+
         /* change verb */
         pa_log_info("Set ucm verb to %s", p->name);
 
@@ -2041,6 +2051,10 @@ static void ucm_probe_profile_set(pa_alsa_ucm_config *ucm, pa_alsa_profile_set *
             m->output_pcm = mapping_open_pcm(ucm, m, SND_PCM_STREAM_PLAYBACK);
             if (!m->output_pcm) {
                 p->supported = false;
+                if (errno == EBUSY || errno == EAGAIN) {
+                    pa_log_debug("Output:%s is busy", m->name);
+                    p->probe_busy = true;
+                }
                 break;
             }
         }
@@ -2056,6 +2070,10 @@ static void ucm_probe_profile_set(pa_alsa_ucm_config *ucm, pa_alsa_profile_set *
                 m->input_pcm = mapping_open_pcm(ucm, m, SND_PCM_STREAM_CAPTURE);
                 if (!m->input_pcm) {
                     p->supported = false;
+                    if (errno == EBUSY || errno == EAGAIN) {
+                        pa_log_debug("Input:%s is busy", m->name);
+                        p->probe_busy = true;
+                    }
                     break;
                 }
             }
@@ -2083,6 +2101,7 @@ static void ucm_probe_profile_set(pa_alsa_ucm_config *ucm, pa_alsa_profile_set *
     snd_use_case_set(ucm->ucm_mgr, "_verb", SND_USE_CASE_VERB_INACTIVE);
 
     pa_alsa_profile_set_drop_unsupported(ps);
+    ps->probed = true;
 }
 
 pa_alsa_profile_set* pa_alsa_ucm_add_profile_set(pa_alsa_ucm_config *ucm, pa_channel_map *default_channel_map) {
@@ -2111,9 +2130,6 @@ pa_alsa_profile_set* pa_alsa_ucm_add_profile_set(pa_alsa_ucm_config *ucm, pa_cha
         ucm_create_profile(ucm, ps, verb, verb_name, verb_desc);
     }
 
-    ucm_probe_profile_set(ucm, ps);
-    ps->probed = true;
-
     return ps;
 }
 
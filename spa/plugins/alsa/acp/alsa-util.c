@@ -766,6 +766,8 @@ snd_pcm_t *pa_alsa_open_by_device_string(
 fail:
     pa_xfree(d);
 
+    /* let the caller see a busy device */
+    errno = err < 0 ? -err : EINVAL;
     return NULL;
 }
 
@@ -785,6 +787,8 @@ snd_pcm_t *pa_alsa_open_by_template(
 
     snd_pcm_t *pcm_handle;
     char **i;
+    int res = ENOENT;
+    bool busy = false;
 
     for (i = template; *i; i++) {
         char *d;
@@ -804,12 +808,16 @@ snd_pcm_t *pa_alsa_open_by_template(
                 use_tsched,
                 require_exact_channel_number);
 
+        res = errno;
         pa_xfree(d);
 
         if (pcm_handle)
             return pcm_handle;
+        if (res == EBUSY || res == EAGAIN)
+            busy = true;
     }
 
+    errno = busy ? EBUSY : res;
     return NULL;
 }
 
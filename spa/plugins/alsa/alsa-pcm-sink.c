@@ -710,7 +710,7 @@ impl_node_port_use_buffers(void *object,
 			   struct spa_buffer **buffers, uint32_t n_buffers)
 {
 	struct state *this = object;
-	uint32_t i;
+	uint32_t i, j;
 	int res;
 
 	spa_return_val_if_fail(this != NULL, -EINVAL);
@@ -743,6 +743,10 @@ impl_node_port_use_buffers(void *object,
 			spa_log_error(this->log, "%p: need mapped memory", this);
 			return -EINVAL;
 		}
+		for (j = 0; j < SPA_MIN(b->buf->n_datas, MAX_DATAS); j++)
+			b->datas[j] = d[j].data;
+		b->maxsize = d[0].maxsize;
+
 		spa_log_debug(this->log, "%p: %d %p data:%p", this, i, b->buf, d[0].data);
 	}
 	this->n_buffers = n_buffers;
@@ -7,8 +7,10 @@
 #include <sys/time.h>
 #include <math.h>
 #include <limits.h>
+#include <pthread.h>
 
 #include <spa/pod/filter.h>
+#include <spa/utils/atomic.h>
 #include <spa/utils/string.h>
 #include <spa/utils/result.h>
 #include <spa/support/system.h>
@@ -17,6 +19,8 @@
 #include "alsa-pcm.h"
 
 static struct spa_list cards = SPA_LIST_INIT(&cards);
+static struct spa_list groups = SPA_LIST_INIT(&groups);
+static pthread_mutex_t groups_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static struct card *find_card(uint32_t index)
 {
@@ -130,6 +134,8 @@ static int alsa_set_param(struct state *state, const char *k, const char *s)
 		state->multi_rate = spa_atob(s);
 	} else if (spa_streq(k, "api.alsa.htimestamp")) {
 		state->htimestamp = spa_atob(s);
+	} else if (spa_streq(k, "api.alsa.zero-copy")) {
+		state->zero_copy = spa_atob(s);
 	} else if (spa_streq(k, "latency.internal.rate")) {
 		state->process_latency.rate = atoi(s);
 	} else if (spa_streq(k, "latency.internal.ns")) {
@@ -318,6 +324,14 @@ struct spa_pod *spa_alsa_enum_propinfo(struct state *state,
 			SPA_PROP_INFO_params, SPA_POD_Bool(true));
 		break;
 	case 15:
+		param = spa_pod_builder_add_object(b,
+			SPA_TYPE_OBJECT_PropInfo, SPA_PARAM_PropInfo,
+			SPA_PROP_INFO_name, SPA_POD_String("api.alsa.zero-copy"),
+			SPA_PROP_INFO_description, SPA_POD_String("Write directly into the mmap area"),
+			SPA_PROP_INFO_type, SPA_POD_CHOICE_Bool(state->zero_copy),
+			SPA_PROP_INFO_params, SPA_POD_Bool(true));
+		break;
+	case 16:
 		param = spa_pod_builder_add_object(b,
 			SPA_TYPE_OBJECT_PropInfo, SPA_PARAM_PropInfo,
 			SPA_PROP_INFO_name, SPA_POD_String("latency.internal.rate"),
@@ -326,7 +340,7 @@ struct spa_pod *spa_alsa_enum_propinfo(struct state *state,
 				0, 65536),
 			SPA_PROP_INFO_params, SPA_POD_Bool(true));
 		break;
-	case 16:
+	case 17:
 		param = spa_pod_builder_add_object(b,
 			SPA_TYPE_OBJECT_PropInfo, SPA_PARAM_PropInfo,
 			SPA_PROP_INFO_name, SPA_POD_String("latency.internal.ns"),
@@ -335,7 +349,7 @@ struct spa_pod *spa_alsa_enum_propinfo(struct state *state,
 				0LL, 2 * SPA_NSEC_PER_SEC),
 			SPA_PROP_INFO_params, SPA_POD_Bool(true));
 		break;
-	case 17:
+	case 18:
 		param = spa_pod_builder_add_object(b,
 			SPA_TYPE_OBJECT_PropInfo, SPA_PARAM_PropInfo,
 			SPA_PROP_INFO_name, SPA_POD_String("clock.name"),
@@ -407,6 +421,9 @@ int spa_alsa_add_prop_params(struct state *state, struct spa_pod_builder *b)
 	spa_pod_builder_string(b, "api.alsa.htimestamp");
 	spa_pod_builder_bool(b, state->htimestamp);
 
+	spa_pod_builder_string(b, "api.alsa.zero-copy");
+	spa_pod_builder_bool(b, state->zero_copy);
+
 	spa_pod_builder_string(b, "latency.internal.rate");
 	spa_pod_builder_int(b, state->process_latency.rate);
 
@@ -515,15 +532,24 @@ int spa_alsa_init(struct state *state, const struct spa_dict *info)
 			state->open_ucm = spa_atob(s);
 		} else if (spa_streq(k, "clock.quantum-limit")) {
 			spa_atou32(s, &state->quantum_limit, 0);
+		} else if (spa_streq(k, "api.alsa.link-group")) {
+			spa_scnprintf(state->link_group,
+					sizeof(state->link_group), "%s", s);
 		} else {
 			alsa_set_param(state, k, s);
 		}
 	}
+	/* devices in the same link group run from the same clock and don't
+	 * need to be rate matched against each other */
+	if (state->clock_name[0] == '\0' && state->link_group[0] != '\0')
+		snprintf(state->clock_name, sizeof(state->clock_name),
+				"api.alsa.link.%s", state->link_group);
 	if (state->clock_name[0] == '\0')
 		snprintf(state->clock_name, sizeof(state->clock_name),
 				"api.alsa.%s-%u",
 				state->stream == SND_PCM_STREAM_PLAYBACK ? "p" : "c",
 				state->card_index);
+	spa_list_init(&state->group_link);
 
 	if (state->stream == SND_PCM_STREAM_PLAYBACK) {
 		state->is_iec958 = spa_strstartswith(state->props.device, "iec958");
@@ -1849,6 +1875,127 @@ static int set_timeout(struct state *state, uint64_t time)
 	return 0;
 }
 
+/* With zero-copy, the datas of the buffers we give to the peer point into
+ * the mmap area at the current write position so that the peer (audioconvert
+ * in the adapter) writes the samples directly into the ringbuffer and
+ * spa_alsa_write() only needs to commit them. When the free space is not
+ * contiguous for at least one cycle, we fall back to the original memory and
+ * the copy in spa_alsa_write(). */
+static void zero_copy_unmap_buffer(struct state *state, struct buffer *b, bool keep)
+{
+	struct spa_data *d = b->buf->datas;
+	uint32_t i;
+
+	if (!SPA_FLAG_IS_SET(b->flags, BUFFER_FLAG_MAPPED))
+		return;
+
+	for (i = 0; i < b->buf->n_datas; i++) {
+		if (keep)
+			memcpy(b->datas[i], d[i].data, SPA_MIN(d[i].maxsize, b->maxsize));
+		d[i].data = b->datas[i];
+		d[i].maxsize = b->maxsize;
+	}
+	SPA_FLAG_CLEAR(b->flags, BUFFER_FLAG_MAPPED);
+}
+
+static void zero_copy_unmap(struct state *state, bool keep)
+{
+	uint32_t i;
+	for (i = 0; i < state->n_buffers; i++)
+		zero_copy_unmap_buffer(state, &state->buffers[i], keep);
+}
+
+/* move the contents of the mapped buffers out of the ringbuffer before
+ * something else (silence, recover) writes into the area */
+static inline void zero_copy_detach(struct state *state)
+{
+	if (SPA_UNLIKELY(state->zero_copy_active))
+		zero_copy_unmap(state, true);
+}
+
+static void zero_copy_setup(struct state *state)
+{
+	uint32_t i, j, n_datas;
+
+	state->zero_copy_active = false;
+
+	if (!state->zero_copy || state->stream != SND_PCM_STREAM_PLAYBACK)
+		return;
+
+	if (!state->use_mmap || state->frame_scale != 1 || state->n_buffers == 0) {
+		spa_log_info(state->log, "%s: zero-copy not possible (mmap:%d scale:%zd)",
+				state->props.device, state->use_mmap, state->frame_scale);
+		return;
+	}
+	n_datas = state->planar ? (uint32_t)state->channels : 1u;
+	for (i = 0; i < state->n_buffers; i++) {
+		struct spa_buffer *buf = state->buffers[i].buf;
+
+		/* only memory that is private to the process can be redirected,
+		 * shared memory is also mapped by the peer */
+		if (buf->n_datas != n_datas || n_datas > MAX_DATAS)
+			return;
+		for (j = 0; j < n_datas; j++) {
+			if (buf->datas[j].type != SPA_DATA_MemPtr) {
+				spa_log_info(state->log, "%s: zero-copy needs MemPtr buffers",
+						state->props.device);
+				return;
+			}
+		}
+	}
+	spa_log_info(state->log, "%s: using zero-copy", state->props.device);
+	state->zero_copy_active = true;
+}
+
+static void zero_copy_update(struct state *state)
+{
+	const snd_pcm_channel_area_t *my_areas;
+	snd_pcm_uframes_t frames, offset;
+	uint32_t i, j, n_datas, maxsize;
+	struct buffer *b;
+
+	if (SPA_LIKELY(!state->zero_copy_active))
+		return;
+
+	/* buffers with pending data are written first, we can't map the
+	 * area after them */
+	if (!spa_list_is_empty(&state->ready))
+		goto fallback;
+
+	frames = state->buffer_frames;
+	if (snd_pcm_mmap_begin(state->hndl, &my_areas, &offset, &frames) < 0 ||
+	    frames < state->threshold)
+		goto fallback;
+
+	n_datas = state->planar ? (uint32_t)state->channels : 1u;
+	for (i = 0; i < n_datas; i++) {
+		if (my_areas[i].step != state->frame_size * 8 ||
+		    (my_areas[i].first % 8) != 0)
+			goto fallback;
+	}
+	maxsize = frames * state->frame_size;
+
+	for (i = 0; i < state->n_buffers; i++) {
+		b = &state->buffers[i];
+		if (!SPA_FLAG_IS_SET(b->flags, BUFFER_FLAG_OUT))
+			continue;
+		for (j = 0; j < n_datas; j++) {
+			b->buf->datas[j].data = channel_area_addr(&my_areas[j], offset);
+			b->buf->datas[j].maxsize = SPA_MIN(b->maxsize, maxsize);
+		}
+		SPA_FLAG_SET(b->flags, BUFFER_FLAG_MAPPED);
+	}
+	return;
+
+fallback:
+	spa_log_trace_fp(state->log, "%p: zero-copy fallback", state);
+	for (i = 0; i < state->n_buffers; i++) {
+		b = &state->buffers[i];
+		if (SPA_FLAG_IS_SET(b->flags, BUFFER_FLAG_OUT))
+			zero_copy_unmap_buffer(state, b, false);
+	}
+}
+
 int spa_alsa_silence(struct state *state, snd_pcm_uframes_t silence)
 {
 	snd_pcm_t *hndl = state->hndl;
@@ -1857,6 +2004,8 @@ int spa_alsa_silence(struct state *state, snd_pcm_uframes_t silence)
 	int i, res;
 
 	if (state->use_mmap) {
+		zero_copy_detach(state);
+
 		frames = state->buffer_frames;
 
 		if (SPA_UNLIKELY((res = snd_pcm_mmap_begin(hndl, &my_areas, &offset, &frames)) < 0)) {
@@ -1895,6 +2044,13 @@ static inline int do_start(struct state *state)
 {
 	int res;
 	if (SPA_UNLIKELY(!state->alsa_started)) {
+		if (SPA_ATOMIC_LOAD(state->linked) &&
+		    snd_pcm_state(state->hndl) == SND_PCM_STATE_RUNNING) {
+			/* started together with another device in the group */
+			spa_log_trace(state->log, "%p: linked start", state);
+			state->alsa_started = true;
+			return 0;
+		}
 		spa_log_trace(state->log, "%p: snd_pcm_start", state);
 		if ((res = snd_pcm_start(state->hndl)) < 0) {
 			spa_log_error(state->log, "%s: snd_pcm_start: %s",
@@ -1906,6 +2062,41 @@ static inline int do_start(struct state *state)
 	return 0;
 }
 
+/* Remove the PCM from its kernel link group. The last remaining member of
+ * the group is not linked to anything anymore.
+ * Must be called with the groups_lock held. */
+static void link_group_unlink_locked(struct state *state)
+{
+	struct state *s, *last = NULL;
+	uint32_t n_linked = 0;
+
+	if (!SPA_ATOMIC_LOAD(state->linked))
+		return;
+
+	snd_pcm_unlink(state->hndl);
+	SPA_ATOMIC_STORE(state->linked, false);
+
+	spa_list_for_each(s, &groups, group_link) {
+		if (!spa_streq(s->link_group, state->link_group) ||
+		    !SPA_ATOMIC_LOAD(s->linked))
+			continue;
+		last = s;
+		n_linked++;
+	}
+	if (n_linked == 1)
+		SPA_ATOMIC_STORE(last->linked, false);
+}
+
+static void link_group_unlink(struct state *state)
+{
+	if (!SPA_ATOMIC_LOAD(state->linked))
+		return;
+
+	pthread_mutex_lock(&groups_lock);
+	link_group_unlink_locked(state);
+	pthread_mutex_unlock(&groups_lock);
+}
+
 static int alsa_recover(struct state *state, int err)
 {
 	int res, st;
@@ -1956,6 +2147,10 @@ static int alsa_recover(struct state *state, int err)
 	}
 
 recover:
+	/* recovering prepares and starts all the PCMs in the link group,
+	 * take this one out of the group and let it run on its own */
+	link_group_unlink(state);
+
 	if (SPA_UNLIKELY((res = snd_pcm_recover(state->hndl, err, true)) < 0)) {
 		spa_log_error(state->log, "%s: snd_pcm_recover error: %s",
 				state->props.device, snd_strerror(res));
@@ -2219,6 +2414,48 @@ static inline int check_position_config(struct state *state)
 	return 0;
 }
 
+static uint64_t get_time_ns(struct state *state)
+{
+	struct timespec now;
+	if (spa_system_clock_gettime(state->data_system, CLOCK_MONOTONIC, &now) < 0)
+		return 0;
+	return SPA_TIMESPEC_TO_NSEC(&now);
+}
+
+/* Keep track of the time between when we were supposed to run (the timer
+ * expiration when driving, the start of the graph cycle when following) and
+ * when we actually got to do the work, and report it periodically. This is
+ * only done when debug logging is enabled. */
+static void wakeup_stats_update(struct state *state, uint64_t target)
+{
+	struct wakeup_stats *st = &state->wakeup_stats;
+	uint64_t now, latency;
+
+	if (SPA_LIKELY(!spa_log_level_topic_enabled(state->log,
+					SPA_LOG_TOPIC_DEFAULT, SPA_LOG_LEVEL_DEBUG)))
+		return;
+
+	now = get_time_ns(state);
+	latency = now > target ? now - target : 0;
+
+	if (st->count == 0 || latency < st->min)
+		st->min = latency;
+	st->max = SPA_MAX(st->max, latency);
+	st->sum += latency;
+	st->count++;
+
+	if (st->last_report == 0)
+		st->last_report = now;
+	else if (now - st->last_report >= WAKEUP_STATS_PERIOD) {
+		spa_log_debug(state->log, "%s: %s wakeup latency avg:%"PRIu64" min:%"PRIu64
+				" max:%"PRIu64" (%u wakeups)", state->props.device,
+				state->following ? "follower" : "driver",
+				st->sum / st->count, st->min, st->max, st->count);
+		spa_zero(*st);
+		st->last_report = now;
+	}
+}
+
 int spa_alsa_write(struct state *state)
 {
 	snd_pcm_t *hndl = state->hndl;
@@ -2239,6 +2476,8 @@ int spa_alsa_write(struct state *state)
 
 		current_time = state->position->clock.nsec;
 
+		wakeup_stats_update(state, current_time);
+
 		if (SPA_UNLIKELY((res = get_status(state, current_time, &avail, &delay, &target)) < 0))
 			return res;
 
@@ -2312,8 +2551,14 @@ again:
 
 		if (SPA_LIKELY(state->use_mmap)) {
 			for (i = 0; i < b->buf->n_datas; i++) {
-				spa_memcpy(channel_area_addr(&my_areas[i], off),
-						SPA_PTROFF(d[i].data, offs, void), n_bytes);
+				void *dst = channel_area_addr(&my_areas[i], off);
+				void *src = SPA_PTROFF(d[i].data, offs, void);
+
+				if (SPA_LIKELY(!SPA_FLAG_IS_SET(b->flags, BUFFER_FLAG_MAPPED)))
+					spa_memcpy(dst, src, n_bytes);
+				else if (dst != src)
+					/* the write position moved after a rewind */
+					memmove(dst, src, n_bytes);
 			}
 		} else {
 			void *bufs[b->buf->n_datas];
@@ -2368,6 +2613,8 @@ again:
 	if (SPA_UNLIKELY(!state->alsa_started && (total_written > 0 || frames == 0)))
 		do_start(state);
 
+	zero_copy_update(state);
+
 	update_sources(state, true);
 
 	return 0;
@@ -2476,6 +2723,8 @@ int spa_alsa_read(struct state *state)
 
 		current_time = state->position->clock.nsec;
 
+		wakeup_stats_update(state, current_time);
+
 		if ((res = get_status(state, current_time, &avail, &delay, &target)) < 0)
 			return res;
 
@@ -2612,6 +2861,8 @@ static int handle_play(struct state *state, uint64_t current_time, snd_pcm_ufram
 
 	update_sources(state, false);
 
+	zero_copy_update(state);
+
 	io->status = SPA_STATUS_NEED_DATA;
 	return spa_node_call_ready(&state->callbacks, SPA_STATUS_NEED_DATA);
 }
@@ -2659,14 +2910,6 @@ static int handle_capture(struct state *state, uint64_t current_time, snd_pcm_uf
 	return 0;
 }
 
-static uint64_t get_time_ns(struct state *state)
-{
-	struct timespec now;
-	if (spa_system_clock_gettime(state->data_system, CLOCK_MONOTONIC, &now) < 0)
-		return 0;
-	return SPA_TIMESPEC_TO_NSEC(&now);
-}
-
 static void alsa_wakeup_event(struct spa_source *source)
 {
 	struct state *state = source->data;
@@ -2712,6 +2955,8 @@ static void alsa_wakeup_event(struct spa_source *source)
 			}
 		}
 		current_time = state->next_time;
+
+		wakeup_stats_update(state, current_time);
 	}
 
 	if (SPA_UNLIKELY((res = check_position_config(state)) < 0)) {
@@ -2832,6 +3077,52 @@ static int do_setup_sources(struct spa_loop *loop,
 	return 0;
 }
 
+/* Link the playback PCM with another prepared PCM of the same link group
+ * so that the first snd_pcm_start() in the group starts all of them in the
+ * same cycle. When the driver does not support linking (or no other device
+ * is waiting to start) the device starts on its own in the first cycle. */
+static void link_group_join(struct state *state)
+{
+	struct state *s;
+	int res;
+
+	if (state->link_group[0] == '\0' || state->stream != SND_PCM_STREAM_PLAYBACK)
+		return;
+
+	pthread_mutex_lock(&groups_lock);
+	spa_list_for_each(s, &groups, group_link) {
+		if (!spa_streq(s->link_group, state->link_group) ||
+		    snd_pcm_state(s->hndl) != SND_PCM_STATE_PREPARED)
+			continue;
+
+		if ((res = snd_pcm_link(s->hndl, state->hndl)) < 0) {
+			spa_log_info(state->log, "%s: can't link with %s: %s",
+					state->props.device, s->props.device,
+					snd_strerror(res));
+			continue;
+		}
+		spa_log_info(state->log, "%s: linked with %s in group '%s'",
+				state->props.device, s->props.device, state->link_group);
+		SPA_ATOMIC_STORE(s->linked, true);
+		SPA_ATOMIC_STORE(state->linked, true);
+		break;
+	}
+	spa_list_append(&groups, &state->group_link);
+	pthread_mutex_unlock(&groups_lock);
+}
+
+static void link_group_leave(struct state *state)
+{
+	if (spa_list_is_empty(&state->group_link))
+		return;
+
+	pthread_mutex_lock(&groups_lock);
+	link_group_unlink_locked(state);
+	spa_list_remove(&state->group_link);
+	spa_list_init(&state->group_link);
+	pthread_mutex_unlock(&groups_lock);
+}
+
 int spa_alsa_start(struct state *state)
 {
 	int err;
@@ -2850,6 +3141,7 @@ int spa_alsa_start(struct state *state)
 
 	spa_dll_init(&state->dll);
 	state->last_threshold = state->threshold;
+	spa_zero(state->wakeup_stats);
 
 	spa_log_debug(state->log, "%p: start %d duration:%d rate:%d follower:%d match:%d resample:%d",
 			state, state->threshold, state->duration, state->rate_denom,
@@ -2902,7 +3194,10 @@ int spa_alsa_start(struct state *state)
 		}
 	}
 
+	link_group_join(state);
+
 	reset_buffers(state);
+	zero_copy_setup(state);
 	state->alsa_sync = true;
 	state->alsa_sync_warning = false;
 	state->alsa_recovering = false;
@@ -2985,10 +3280,15 @@ int spa_alsa_pause(struct state *state)
 
 	spa_loop_invoke(state->data_loop, do_remove_source, 0, NULL, 0, true, state);
 
+	/* a drop on a linked PCM stops all the PCMs in the group */
+	link_group_leave(state);
+
 	if ((err = snd_pcm_drop(state->hndl)) < 0)
 		spa_log_error(state->log, "%s: snd_pcm_drop %s", state->props.device,
 				snd_strerror(err));
 
+	zero_copy_unmap(state, false);
+	state->zero_copy_active = false;
 	state->started = false;
 
 	return 0;
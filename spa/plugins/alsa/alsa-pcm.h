@@ -52,14 +52,19 @@ struct props {
 
 #define MAX_BUFFERS 32
 #define MAX_POLL 16
+#define MAX_DATAS SPA_AUDIO_MAX_CHANNELS
 
 struct buffer {
 	uint32_t id;
-#define BUFFER_FLAG_OUT	(1<<0)
+#define BUFFER_FLAG_OUT		(1<<0)
+#define BUFFER_FLAG_MAPPED	(1<<1)
 	uint32_t flags;
 	struct spa_buffer *buf;
 	struct spa_meta_header *h;
 	struct spa_list link;
+	/* the original memory when the datas point into the mmap area */
+	void *datas[MAX_DATAS];
+	uint32_t maxsize;
 };
 
 #define BW_MAX		0.128
@@ -72,6 +77,16 @@ struct channel_map {
 	uint32_t pos[SPA_AUDIO_MAX_CHANNELS];
 };
 
+#define WAKEUP_STATS_PERIOD	(10 * SPA_NSEC_PER_SEC)
+
+struct wakeup_stats {
+	uint64_t last_report;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	uint32_t count;
+};
+
 struct card {
 	struct spa_list link;
 	int ref;
@@ -130,7 +145,9 @@ struct state {
 	unsigned int disable_mmap;
 	unsigned int disable_batch;
 	unsigned int disable_tsched;
+	unsigned int zero_copy;
 	char clock_name[64];
+	char link_group[64];
 	uint32_t quantum_limit;
 
 	snd_pcm_uframes_t buffer_frames;
@@ -167,6 +184,9 @@ struct state {
 	struct spa_list free;
 	struct spa_list ready;
 
+	struct spa_list group_link;
+	bool linked;			/* in a kernel link group, also changed by the peers */
+
 	size_t ready_offset;
 
 	bool started;
@@ -199,6 +219,7 @@ struct state {
 	unsigned int is_hdmi:1;
 	unsigned int multi_rate:1;
 	unsigned int htimestamp:1;
+	unsigned int zero_copy_active:1;
 
 	uint64_t iec958_codecs;
 
@@ -210,6 +231,8 @@ struct state {
 
 	uint64_t underrun;
 
+	struct wakeup_stats wakeup_stats;
+
 	struct spa_dll dll;
 	double max_error;
 	double max_resync;
@@ -0,0 +1,275 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include "config.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include "test-helper.h"
+#include "channelmix-ops.h"
+#include "volume-ops.h"
+
+static uint32_t cpu_flags;
+
+typedef void (*channelmix_func_t) (struct channelmix *mix, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], uint32_t n_samples);
+typedef void (*volume_func_t) (struct volume *vol, void * SPA_RESTRICT dst,
+		const void * SPA_RESTRICT src, float volume, uint32_t n_samples);
+
+struct stats {
+	uint32_t n_samples;
+	uint32_t src_chan;
+	uint32_t dst_chan;
+	uint64_t perf;
+	const char *name;
+	const char *impl;
+};
+
+#define MAX_SAMPLES	4096
+#define MAX_CHANNELS	64
+
+#define MAX_COUNT 100
+
+static float samp_in[MAX_SAMPLES * MAX_CHANNELS] SPA_ALIGNED(32);
+static float samp_out[MAX_SAMPLES * MAX_CHANNELS] SPA_ALIGNED(32);
+static struct channelmix mix;
+
+static const int sample_sizes[] = { 0, 1, 128, 513, 4096 };
+static const struct {
+	uint32_t src_chan;
+	uint32_t dst_chan;
+} n_m_sizes[] = { { 2, 2 }, { 6, 2 }, { 8, 2 }, { 2, 8 }, { 8, 8 }, { 16, 12 } };
+
+#define MAX_RESULTS	SPA_N_ELEMENTS(sample_sizes) * (SPA_N_ELEMENTS(n_m_sizes) + 5) * 4
+
+static uint32_t n_results = 0;
+static struct stats results[MAX_RESULTS];
+
+static void setup_mix(uint32_t src_chan, uint32_t dst_chan, bool sparse)
+{
+	uint32_t i, j;
+
+	spa_zero(mix);
+	mix.src_chan = src_chan;
+	mix.dst_chan = dst_chan;
+	mix.cpu_flags = cpu_flags;
+	spa_assert_se(channelmix_init(&mix) == 0);
+
+	/* a dense matrix, every source contributes to every destination,
+	 * or a sparse routing with one source per destination */
+	for (i = 0; i < dst_chan; i++)
+		for (j = 0; j < src_chan; j++)
+			mix.matrix_orig[i][j] = sparse ? (j == (i * 5 + 3) % src_chan ? 1.0f : 0.0f) :
+				i == j ? 1.0f : 0.5f / src_chan;
+	channelmix_set_volume(&mix, 1.0f, false, 0, NULL);
+}
+
+static void run_test1(const char *name, const char *impl, channelmix_func_t func,
+		uint32_t src_chan, uint32_t dst_chan, bool sparse, int n_samples)
+{
+	int i;
+	uint32_t j;
+	const void *ip[src_chan];
+	void *op[dst_chan];
+	struct timespec ts;
+	uint64_t count, t1, t2;
+
+	setup_mix(src_chan, dst_chan, sparse);
+
+	for (j = 0; j < src_chan; j++)
+		ip[j] = &samp_in[j * MAX_SAMPLES];
+	for (j = 0; j < dst_chan; j++)
+		op[j] = &samp_out[j * MAX_SAMPLES];
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t1 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+	count = 0;
+	for (i = 0; i < MAX_COUNT; i++) {
+		func(&mix, op, ip, n_samples);
+		count++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t2 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+	spa_assert(n_results < MAX_RESULTS);
+
+	results[n_results++] = (struct stats) {
+		.n_samples = n_samples,
+		.src_chan = src_chan,
+		.dst_chan = dst_chan,
+		.perf = count * (uint64_t)SPA_NSEC_PER_SEC / SPA_MAX(t2 - t1, 1u),
+		.name = name,
+		.impl = impl
+	};
+}
+
+static void run_test(const char *name, const char *impl, channelmix_func_t func,
+		uint32_t src_chan, uint32_t dst_chan, bool sparse)
+{
+	SPA_FOR_EACH_ELEMENT_VAR(sample_sizes, s)
+		run_test1(name, impl, func, src_chan, dst_chan, sparse, *s);
+}
+
+static void run_test_n_m(const char *impl, channelmix_func_t func)
+{
+	SPA_FOR_EACH_ELEMENT_VAR(n_m_sizes, c)
+		run_test("test_f32_n_m", impl, func, c->src_chan, c->dst_chan, false);
+	run_test("test_f32_n_m_sparse", impl, func, 64, 64, true);
+}
+
+static void run_volume(const char *impl, volume_func_t func)
+{
+	struct volume vol;
+	struct timespec ts;
+	uint64_t count, t1, t2;
+	int i;
+
+	spa_zero(vol);
+	vol.cpu_flags = cpu_flags;
+
+	SPA_FOR_EACH_ELEMENT_VAR(sample_sizes, s) {
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		t1 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+		count = 0;
+		for (i = 0; i < MAX_COUNT; i++) {
+			func(&vol, samp_out, samp_in, 0.5f, *s);
+			count++;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		t2 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+		spa_assert(n_results < MAX_RESULTS);
+
+		results[n_results++] = (struct stats) {
+			.n_samples = *s,
+			.src_chan = 1,
+			.dst_chan = 1,
+			.perf = count * (uint64_t)SPA_NSEC_PER_SEC / SPA_MAX(t2 - t1, 1u),
+			.name = "test_volume_f32",
+			.impl = impl
+		};
+	}
+}
+
+static void test_n_m(void)
+{
+	run_test_n_m("c", channelmix_f32_n_m_c);
+#if defined (HAVE_SSE)
+	if (cpu_flags & SPA_CPU_FLAG_SSE)
+		run_test_n_m("sse", channelmix_f32_n_m_sse);
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3))
+		run_test_n_m("avx", channelmix_f32_n_m_avx);
+#endif
+#if defined (HAVE_NEON)
+	if (cpu_flags & SPA_CPU_FLAG_NEON)
+		run_test_n_m("neon", channelmix_f32_n_m_neon);
+#endif
+}
+
+static void test_5p1_2(void)
+{
+	run_test("test_f32_5p1_2", "c", channelmix_f32_5p1_2_c, 6, 2, false);
+#if defined (HAVE_SSE)
+	if (cpu_flags & SPA_CPU_FLAG_SSE)
+		run_test("test_f32_5p1_2", "sse", channelmix_f32_5p1_2_sse, 6, 2, false);
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3))
+		run_test("test_f32_5p1_2", "avx", channelmix_f32_5p1_2_avx, 6, 2, false);
+#endif
+}
+
+static void test_7p1_2(void)
+{
+	run_test("test_f32_7p1_2", "c", channelmix_f32_7p1_2_c, 8, 2, false);
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3))
+		run_test("test_f32_7p1_2", "avx", channelmix_f32_7p1_2_avx, 8, 2, false);
+#endif
+#if defined (HAVE_NEON)
+	if (cpu_flags & SPA_CPU_FLAG_NEON)
+		run_test("test_f32_7p1_2", "neon", channelmix_f32_7p1_2_neon, 8, 2, false);
+#endif
+}
+
+static void test_copy(void)
+{
+	run_test("test_copy", "c", channelmix_copy_c, 8, 8, false);
+#if defined (HAVE_SSE)
+	if (cpu_flags & SPA_CPU_FLAG_SSE)
+		run_test("test_copy", "sse", channelmix_copy_sse, 8, 8, false);
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3))
+		run_test("test_copy", "avx", channelmix_copy_avx, 8, 8, false);
+#endif
+#if defined (HAVE_NEON)
+	if (cpu_flags & SPA_CPU_FLAG_NEON)
+		run_test("test_copy", "neon", channelmix_copy_neon, 8, 8, false);
+#endif
+}
+
+static void test_volume(void)
+{
+	run_volume("c", volume_f32_c);
+#if defined (HAVE_SSE)
+	if (cpu_flags & SPA_CPU_FLAG_SSE)
+		run_volume("sse", volume_f32_sse);
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3))
+		run_volume("avx", volume_f32_avx);
+#endif
+#if defined (HAVE_NEON)
+	if (cpu_flags & SPA_CPU_FLAG_NEON)
+		run_volume("neon", volume_f32_neon);
+#endif
+}
+
+static int compare_func(const void *_a, const void *_b)
+{
+	const struct stats *a = _a, *b = _b;
+	int diff;
+	if ((diff = strcmp(a->name, b->name)) != 0) return diff;
+	if ((diff = a->n_samples - b->n_samples) != 0) return diff;
+	if ((diff = a->src_chan - b->src_chan) != 0) return diff;
+	if ((diff = a->dst_chan - b->dst_chan) != 0) return diff;
+	if ((diff = b->perf - a->perf) != 0) return diff;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t i;
+
+	cpu_flags = get_cpu_flags();
+	printf("got get CPU flags %d\n", cpu_flags);
+
+	for (i = 0; i < SPA_N_ELEMENTS(samp_in); i++)
+		samp_in[i] = (float)(drand48() * 2.0 - 1.0);
+
+	test_n_m();
+	test_5p1_2();
+	test_7p1_2();
+	test_copy();
+	test_volume();
+
+	qsort(results, n_results, sizeof(struct stats), compare_func);
+
+	for (i = 0; i < n_results; i++) {
+		struct stats *s = &results[i];
+		fprintf(stderr, "%-12."PRIu64" \t%-32.32s %s \t samples %d, channels %d -> %d\n",
+				s->perf, s->name, s->impl, s->n_samples, s->src_chan, s->dst_chan);
+	}
+	return 0;
+}
@@ -0,0 +1,250 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include "channelmix-ops.h"
+
+#include <immintrin.h>
+
+static inline void clear_avx(float *d, uint32_t n_samples)
+{
+	memset(d, 0, n_samples * sizeof(float));
+}
+
+static inline void copy_avx(float *d, const float *s, uint32_t n_samples)
+{
+	spa_memcpy(d, s, n_samples * sizeof(float));
+}
+
+static inline void vol_avx(float *d, const float *s, float vol, uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	if (vol == 0.0f) {
+		clear_avx(d, n_samples);
+	} else if (vol == 1.0f) {
+		copy_avx(d, s, n_samples);
+	} else {
+		__m256 t[4];
+		const __m256 v = _mm256_set1_ps(vol);
+
+		if (SPA_IS_ALIGNED(d, 32) &&
+		    SPA_IS_ALIGNED(s, 32))
+			unrolled = n_samples & ~31;
+		else
+			unrolled = 0;
+
+		for(n = 0; n < unrolled; n += 32) {
+			t[0] = _mm256_load_ps(&s[n]);
+			t[1] = _mm256_load_ps(&s[n+8]);
+			t[2] = _mm256_load_ps(&s[n+16]);
+			t[3] = _mm256_load_ps(&s[n+24]);
+			_mm256_store_ps(&d[n], _mm256_mul_ps(t[0], v));
+			_mm256_store_ps(&d[n+8], _mm256_mul_ps(t[1], v));
+			_mm256_store_ps(&d[n+16], _mm256_mul_ps(t[2], v));
+			_mm256_store_ps(&d[n+24], _mm256_mul_ps(t[3], v));
+		}
+		for(; n < n_samples; n++)
+			_mm_store_ss(&d[n], _mm_mul_ss(_mm_load_ss(&s[n]), _mm256_castps256_ps128(v)));
+	}
+}
+
+static inline void conv_avx(float *d, const float **s, float *c, uint32_t n_c, uint32_t n_samples)
+{
+	__m256 mi[n_c], sum[2];
+	uint32_t n, j, unrolled;
+	bool aligned = true;
+
+	for (j = 0; j < n_c; j++) {
+		mi[j] = _mm256_set1_ps(c[j]);
+		aligned &= SPA_IS_ALIGNED(s[j], 32);
+	}
+
+	if (aligned && SPA_IS_ALIGNED(d, 32))
+		unrolled = n_samples & ~15;
+	else
+		unrolled = 0;
+
+	/* this is built with FMA, the compiler can fuse the multiply and add so
+	 * the last bits can differ from the C and SSE versions */
+	for (n = 0; n < unrolled; n += 16) {
+		sum[0] = sum[1] = _mm256_setzero_ps();
+		for (j = 0; j < n_c; j++) {
+			sum[0] = _mm256_add_ps(sum[0], _mm256_mul_ps(_mm256_load_ps(&s[j][n + 0]), mi[j]));
+			sum[1] = _mm256_add_ps(sum[1], _mm256_mul_ps(_mm256_load_ps(&s[j][n + 8]), mi[j]));
+		}
+		_mm256_store_ps(&d[n + 0], sum[0]);
+		_mm256_store_ps(&d[n + 8], sum[1]);
+	}
+	for (; n < n_samples; n++) {
+		__m128 s0 = _mm_setzero_ps();
+		for (j = 0; j < n_c; j++)
+			s0 = _mm_add_ss(s0, _mm_mul_ss(_mm_load_ss(&s[j][n]),
+						_mm256_castps256_ps128(mi[j])));
+		_mm_store_ss(&d[n], s0);
+	}
+}
+
+void channelmix_copy_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t i, n_dst = mix->dst_chan;
+	float **d = (float **)dst;
+	const float **s = (const float **)src;
+	for (i = 0; i < n_dst; i++)
+		vol_avx(d[i], s[i], mix->matrix[i][i], n_samples);
+}
+
+void
+channelmix_f32_n_m_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		   const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	uint32_t i, j, n_dst = mix->dst_chan;
+
+	for (i = 0; i < n_dst; i++) {
+		struct channelmix_plan *p = &mix->plan[i];
+		float *di = d[i];
+
+		if (p->n_src == 0) {
+			clear_avx(di, n_samples);
+		} else if (p->n_src == 1) {
+			if (mix->lr4[i].active)
+				lr4_process(&mix->lr4[i], di, s[p->src[0]], p->coef[0], n_samples);
+			else
+				vol_avx(di, s[p->src[0]], p->coef[0], n_samples);
+		} else {
+			const float *sj[p->n_src];
+			for (j = 0; j < p->n_src; j++)
+				sj[j] = s[p->src[j]];
+			conv_avx(di, sj, p->coef, p->n_src, n_samples);
+			lr4_process(&mix->lr4[i], di, di, 1.0f, n_samples);
+		}
+	}
+}
+
+/* FL+FR+FC+LFE+SL+SR -> FL+FR */
+void
+channelmix_f32_5p1_2_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	const __m256 v0 = _mm256_set1_ps(mix->matrix[0][0]);
+	const __m256 v1 = _mm256_set1_ps(mix->matrix[1][1]);
+	const __m256 clev = _mm256_set1_ps((mix->matrix[0][2] + mix->matrix[1][2]) * 0.5f);
+	const __m256 llev = _mm256_set1_ps((mix->matrix[0][3] + mix->matrix[1][3]) * 0.5f);
+	const __m256 slev0 = _mm256_set1_ps(mix->matrix[0][4]);
+	const __m256 slev1 = _mm256_set1_ps(mix->matrix[1][5]);
+	__m256 in, ctr;
+	__m128 in1, ctr1;
+
+	if (SPA_IS_ALIGNED(s[0], 32) &&
+	    SPA_IS_ALIGNED(s[1], 32) &&
+	    SPA_IS_ALIGNED(s[2], 32) &&
+	    SPA_IS_ALIGNED(s[3], 32) &&
+	    SPA_IS_ALIGNED(s[4], 32) &&
+	    SPA_IS_ALIGNED(s[5], 32) &&
+	    SPA_IS_ALIGNED(d[0], 32) &&
+	    SPA_IS_ALIGNED(d[1], 32))
+		unrolled = n_samples & ~7;
+	else
+		unrolled = 0;
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		clear_avx(d[0], n_samples);
+		clear_avx(d[1], n_samples);
+	}
+	else {
+		for(n = 0; n < unrolled; n += 8) {
+			ctr = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(&s[2][n]), clev),
+					_mm256_mul_ps(_mm256_load_ps(&s[3][n]), llev));
+			in = _mm256_mul_ps(_mm256_load_ps(&s[4][n]), slev0);
+			in = _mm256_add_ps(in, ctr);
+			in = _mm256_add_ps(in, _mm256_mul_ps(_mm256_load_ps(&s[0][n]), v0));
+			_mm256_store_ps(&d[0][n], in);
+			in = _mm256_mul_ps(_mm256_load_ps(&s[5][n]), slev1);
+			in = _mm256_add_ps(in, ctr);
+			in = _mm256_add_ps(in, _mm256_mul_ps(_mm256_load_ps(&s[1][n]), v1));
+			_mm256_store_ps(&d[1][n], in);
+		}
+		for(; n < n_samples; n++) {
+			ctr1 = _mm_mul_ss(_mm_load_ss(&s[2][n]), _mm256_castps256_ps128(clev));
+			ctr1 = _mm_add_ss(ctr1, _mm_mul_ss(_mm_load_ss(&s[3][n]), _mm256_castps256_ps128(llev)));
+			in1 = _mm_mul_ss(_mm_load_ss(&s[4][n]), _mm256_castps256_ps128(slev0));
+			in1 = _mm_add_ss(in1, ctr1);
+			in1 = _mm_add_ss(in1, _mm_mul_ss(_mm_load_ss(&s[0][n]), _mm256_castps256_ps128(v0)));
+			_mm_store_ss(&d[0][n], in1);
+			in1 = _mm_mul_ss(_mm_load_ss(&s[5][n]), _mm256_castps256_ps128(slev1));
+			in1 = _mm_add_ss(in1, ctr1);
+			in1 = _mm_add_ss(in1, _mm_mul_ss(_mm_load_ss(&s[1][n]), _mm256_castps256_ps128(v1)));
+			_mm_store_ss(&d[1][n], in1);
+		}
+	}
+}
+
+/* FL+FR+FC+LFE+SL+SR+RL+RR -> FL+FR */
+void
+channelmix_f32_7p1_2_avx(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	const __m256 v0 = _mm256_set1_ps(mix->matrix[0][0]);
+	const __m256 v1 = _mm256_set1_ps(mix->matrix[1][1]);
+	const __m256 clev = _mm256_set1_ps((mix->matrix[0][2] + mix->matrix[1][2]) * 0.5f);
+	const __m256 llev = _mm256_set1_ps((mix->matrix[0][3] + mix->matrix[1][3]) * 0.5f);
+	const __m256 slev0 = _mm256_set1_ps(mix->matrix[0][4]);
+	const __m256 slev1 = _mm256_set1_ps(mix->matrix[1][5]);
+	const __m256 rlev0 = _mm256_set1_ps(mix->matrix[0][6]);
+	const __m256 rlev1 = _mm256_set1_ps(mix->matrix[1][7]);
+	__m256 in, ctr;
+	__m128 in1, ctr1;
+
+	if (SPA_IS_ALIGNED(s[0], 32) &&
+	    SPA_IS_ALIGNED(s[1], 32) &&
+	    SPA_IS_ALIGNED(s[2], 32) &&
+	    SPA_IS_ALIGNED(s[3], 32) &&
+	    SPA_IS_ALIGNED(s[4], 32) &&
+	    SPA_IS_ALIGNED(s[5], 32) &&
+	    SPA_IS_ALIGNED(s[6], 32) &&
+	    SPA_IS_ALIGNED(s[7], 32) &&
+	    SPA_IS_ALIGNED(d[0], 32) &&
+	    SPA_IS_ALIGNED(d[1], 32))
+		unrolled = n_samples & ~7;
+	else
+		unrolled = 0;
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		clear_avx(d[0], n_samples);
+		clear_avx(d[1], n_samples);
+	}
+	else {
+		for(n = 0; n < unrolled; n += 8) {
+			ctr = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(&s[2][n]), clev),
+					_mm256_mul_ps(_mm256_load_ps(&s[3][n]), llev));
+			in = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(&s[0][n]), v0), ctr);
+			in = _mm256_add_ps(in, _mm256_mul_ps(_mm256_load_ps(&s[4][n]), slev0));
+			in = _mm256_add_ps(in, _mm256_mul_ps(_mm256_load_ps(&s[6][n]), rlev0));
+			_mm256_store_ps(&d[0][n], in);
+			in = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(&s[1][n]), v1), ctr);
+			in = _mm256_add_ps(in, _mm256_mul_ps(_mm256_load_ps(&s[5][n]), slev1));
+			in = _mm256_add_ps(in, _mm256_mul_ps(_mm256_load_ps(&s[7][n]), rlev1));
+			_mm256_store_ps(&d[1][n], in);
+		}
+		for(; n < n_samples; n++) {
+			ctr1 = _mm_add_ss(_mm_mul_ss(_mm_load_ss(&s[2][n]), _mm256_castps256_ps128(clev)),
+					_mm_mul_ss(_mm_load_ss(&s[3][n]), _mm256_castps256_ps128(llev)));
+			in1 = _mm_add_ss(_mm_mul_ss(_mm_load_ss(&s[0][n]), _mm256_castps256_ps128(v0)), ctr1);
+			in1 = _mm_add_ss(in1, _mm_mul_ss(_mm_load_ss(&s[4][n]), _mm256_castps256_ps128(slev0)));
+			in1 = _mm_add_ss(in1, _mm_mul_ss(_mm_load_ss(&s[6][n]), _mm256_castps256_ps128(rlev0)));
+			_mm_store_ss(&d[0][n], in1);
+			in1 = _mm_add_ss(_mm_mul_ss(_mm_load_ss(&s[1][n]), _mm256_castps256_ps128(v1)), ctr1);
+			in1 = _mm_add_ss(in1, _mm_mul_ss(_mm_load_ss(&s[5][n]), _mm256_castps256_ps128(slev1)));
+			in1 = _mm_add_ss(in1, _mm_mul_ss(_mm_load_ss(&s[7][n]), _mm256_castps256_ps128(rlev1)));
+			_mm_store_ss(&d[1][n], in1);
+		}
+	}
+}
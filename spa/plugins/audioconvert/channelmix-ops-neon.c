@@ -0,0 +1,165 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include "channelmix-ops.h"
+
+#include <arm_neon.h>
+
+static inline void clear_neon(float *d, uint32_t n_samples)
+{
+	memset(d, 0, n_samples * sizeof(float));
+}
+
+static inline void copy_neon(float *d, const float *s, uint32_t n_samples)
+{
+	spa_memcpy(d, s, n_samples * sizeof(float));
+}
+
+static inline void vol_neon(float *d, const float *s, float vol, uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	if (vol == 0.0f) {
+		clear_neon(d, n_samples);
+	} else if (vol == 1.0f) {
+		copy_neon(d, s, n_samples);
+	} else {
+		const float32x4_t v = vdupq_n_f32(vol);
+
+		unrolled = n_samples & ~15;
+
+		for(n = 0; n < unrolled; n += 16) {
+			float32x4_t t0 = vld1q_f32(&s[n]);
+			float32x4_t t1 = vld1q_f32(&s[n+4]);
+			float32x4_t t2 = vld1q_f32(&s[n+8]);
+			float32x4_t t3 = vld1q_f32(&s[n+12]);
+			vst1q_f32(&d[n], vmulq_f32(t0, v));
+			vst1q_f32(&d[n+4], vmulq_f32(t1, v));
+			vst1q_f32(&d[n+8], vmulq_f32(t2, v));
+			vst1q_f32(&d[n+12], vmulq_f32(t3, v));
+		}
+		for(; n < n_samples; n++)
+			d[n] = s[n] * vol;
+	}
+}
+
+static inline void conv_neon(float *d, const float **s, float *c, uint32_t n_c, uint32_t n_samples)
+{
+	float32x4_t mi[n_c], sum[2];
+	uint32_t n, j, unrolled;
+
+	for (j = 0; j < n_c; j++)
+		mi[j] = vdupq_n_f32(c[j]);
+
+	unrolled = n_samples & ~7;
+
+	/* separate multiply and add, keep the rounding the same as the C version */
+	for (n = 0; n < unrolled; n += 8) {
+		sum[0] = sum[1] = vdupq_n_f32(0.0f);
+		for (j = 0; j < n_c; j++) {
+			sum[0] = vaddq_f32(sum[0], vmulq_f32(vld1q_f32(&s[j][n + 0]), mi[j]));
+			sum[1] = vaddq_f32(sum[1], vmulq_f32(vld1q_f32(&s[j][n + 4]), mi[j]));
+		}
+		vst1q_f32(&d[n + 0], sum[0]);
+		vst1q_f32(&d[n + 4], sum[1]);
+	}
+	for (; n < n_samples; n++) {
+		float s0 = 0.0f;
+		for (j = 0; j < n_c; j++)
+			s0 += s[j][n] * c[j];
+		d[n] = s0;
+	}
+}
+
+void channelmix_copy_neon(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t i, n_dst = mix->dst_chan;
+	float **d = (float **)dst;
+	const float **s = (const float **)src;
+	for (i = 0; i < n_dst; i++)
+		vol_neon(d[i], s[i], mix->matrix[i][i], n_samples);
+}
+
+void
+channelmix_f32_n_m_neon(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		   const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	uint32_t i, j, n_dst = mix->dst_chan;
+
+	for (i = 0; i < n_dst; i++) {
+		struct channelmix_plan *p = &mix->plan[i];
+		float *di = d[i];
+
+		if (p->n_src == 0) {
+			clear_neon(di, n_samples);
+		} else if (p->n_src == 1) {
+			if (mix->lr4[i].active)
+				lr4_process(&mix->lr4[i], di, s[p->src[0]], p->coef[0], n_samples);
+			else
+				vol_neon(di, s[p->src[0]], p->coef[0], n_samples);
+		} else {
+			const float *sj[p->n_src];
+			for (j = 0; j < p->n_src; j++)
+				sj[j] = s[p->src[j]];
+			conv_neon(di, sj, p->coef, p->n_src, n_samples);
+			lr4_process(&mix->lr4[i], di, di, 1.0f, n_samples);
+		}
+	}
+}
+
+/* FL+FR+FC+LFE+SL+SR+RL+RR -> FL+FR */
+void
+channelmix_f32_7p1_2_neon(struct channelmix *mix, void * SPA_RESTRICT dst[],
+		const void * SPA_RESTRICT src[], uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	float **d = (float **) dst;
+	const float **s = (const float **) src;
+	const float m0 = mix->matrix[0][0];
+	const float m1 = mix->matrix[1][1];
+	const float mc = (mix->matrix[0][2] + mix->matrix[1][2]) * 0.5f;
+	const float ml = (mix->matrix[0][3] + mix->matrix[1][3]) * 0.5f;
+	const float ms0 = mix->matrix[0][4];
+	const float ms1 = mix->matrix[1][5];
+	const float mr0 = mix->matrix[0][6];
+	const float mr1 = mix->matrix[1][7];
+
+	if (SPA_FLAG_IS_SET(mix->flags, CHANNELMIX_FLAG_ZERO)) {
+		clear_neon(d[0], n_samples);
+		clear_neon(d[1], n_samples);
+	}
+	else {
+		const float32x4_t v0 = vdupq_n_f32(m0);
+		const float32x4_t v1 = vdupq_n_f32(m1);
+		const float32x4_t clev = vdupq_n_f32(mc);
+		const float32x4_t llev = vdupq_n_f32(ml);
+		const float32x4_t slev0 = vdupq_n_f32(ms0);
+		const float32x4_t slev1 = vdupq_n_f32(ms1);
+		const float32x4_t rlev0 = vdupq_n_f32(mr0);
+		const float32x4_t rlev1 = vdupq_n_f32(mr1);
+		float32x4_t in, ctr;
+
+		unrolled = n_samples & ~3;
+
+		for(n = 0; n < unrolled; n += 4) {
+			ctr = vaddq_f32(vmulq_f32(vld1q_f32(&s[2][n]), clev),
+					vmulq_f32(vld1q_f32(&s[3][n]), llev));
+			in = vaddq_f32(vmulq_f32(vld1q_f32(&s[0][n]), v0), ctr);
+			in = vaddq_f32(in, vmulq_f32(vld1q_f32(&s[4][n]), slev0));
+			in = vaddq_f32(in, vmulq_f32(vld1q_f32(&s[6][n]), rlev0));
+			vst1q_f32(&d[0][n], in);
+			in = vaddq_f32(vmulq_f32(vld1q_f32(&s[1][n]), v1), ctr);
+			in = vaddq_f32(in, vmulq_f32(vld1q_f32(&s[5][n]), slev1));
+			in = vaddq_f32(in, vmulq_f32(vld1q_f32(&s[7][n]), rlev1));
+			vst1q_f32(&d[1][n], in);
+		}
+		for(; n < n_samples; n++) {
+			const float c = mc * s[2][n] + ml * s[3][n];
+			d[0][n] = s[0][n] * m0 + c + s[4][n] * ms0 + s[6][n] * mr0;
+			d[1][n] = s[1][n] * m1 + c + s[5][n] * ms1 + s[7][n] * mr1;
+		}
+	}
+}
@@ -155,29 +155,24 @@ channelmix_f32_n_m_sse(struct channelmix *mix, void * SPA_RESTRICT dst[],
 {
 	float **d = (float **) dst;
 	const float **s = (const float **) src;
-	uint32_t i, j, n_dst = mix->dst_chan, n_src = mix->src_chan;
+	uint32_t i, j, n_dst = mix->dst_chan;
 
 	for (i = 0; i < n_dst; i++) {
+		struct channelmix_plan *p = &mix->plan[i];
 		float *di = d[i];
-		float mj[n_src];
-		const float *sj[n_src];
-		uint32_t n_j = 0;
-
-		for (j = 0; j < n_src; j++) {
-			if (mix->matrix[i][j] == 0.0f)
-				continue;
-			mj[n_j] = mix->matrix[i][j];
-			sj[n_j++] = s[j];
-		}
-		if (n_j == 0) {
+
+		if (p->n_src == 0) {
 			clear_sse(di, n_samples);
-		} else if (n_j == 1) {
+		} else if (p->n_src == 1) {
 			if (mix->lr4[i].active)
-				lr4_process(&mix->lr4[i], di, sj[0], mj[0], n_samples);
+				lr4_process(&mix->lr4[i], di, s[p->src[0]], p->coef[0], n_samples);
 			else
-				vol_sse(di, sj[0], mj[0], n_samples);
+				vol_sse(di, s[p->src[0]], p->coef[0], n_samples);
 		} else {
-			conv_sse(di, sj, mj, n_j, n_samples);
+			const float *sj[p->n_src];
+			for (j = 0; j < p->n_src; j++)
+				sj[j] = s[p->src[j]];
+			conv_sse(di, sj, p->coef, p->n_src, n_samples);
 			lr4_process(&mix->lr4[i], di, di, 1.0f, n_samples);
 		}
 	}
@@ -36,6 +36,16 @@ static const struct channelmix_info {
 	uint32_t cpu_flags;
 } channelmix_table[] =
 {
+#if defined (HAVE_NEON)
+	MAKE(2, MASK_MONO, 2, MASK_MONO, channelmix_copy_neon, SPA_CPU_FLAG_NEON),
+	MAKE(2, MASK_STEREO, 2, MASK_STEREO, channelmix_copy_neon, SPA_CPU_FLAG_NEON),
+	MAKE(EQ, 0, EQ, 0, channelmix_copy_neon, SPA_CPU_FLAG_NEON),
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	MAKE(2, MASK_MONO, 2, MASK_MONO, channelmix_copy_avx, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3),
+	MAKE(2, MASK_STEREO, 2, MASK_STEREO, channelmix_copy_avx, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3),
+	MAKE(EQ, 0, EQ, 0, channelmix_copy_avx, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3),
+#endif
 #if defined (HAVE_SSE)
 	MAKE(2, MASK_MONO, 2, MASK_MONO, channelmix_copy_sse, SPA_CPU_FLAG_SSE),
 	MAKE(2, MASK_STEREO, 2, MASK_STEREO, channelmix_copy_sse, SPA_CPU_FLAG_SSE),
@@ -66,6 +76,9 @@ static const struct channelmix_info {
 	MAKE(4, MASK_3_1, 2, MASK_STEREO, channelmix_f32_3p1_2_sse, SPA_CPU_FLAG_SSE),
 #endif
 	MAKE(4, MASK_3_1, 2, MASK_STEREO, channelmix_f32_3p1_2_c),
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	MAKE(6, MASK_5_1, 2, MASK_STEREO, channelmix_f32_5p1_2_avx, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3),
+#endif
 #if defined (HAVE_SSE)
 	MAKE(6, MASK_5_1, 2, MASK_STEREO, channelmix_f32_5p1_2_sse, SPA_CPU_FLAG_SSE),
 #endif
@@ -80,10 +93,22 @@ static const struct channelmix_info {
 #endif
 	MAKE(6, MASK_5_1, 4, MASK_3_1, channelmix_f32_5p1_3p1_c),
 
+#if defined (HAVE_NEON)
+	MAKE(8, MASK_7_1, 2, MASK_STEREO, channelmix_f32_7p1_2_neon, SPA_CPU_FLAG_NEON),
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	MAKE(8, MASK_7_1, 2, MASK_STEREO, channelmix_f32_7p1_2_avx, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3),
+#endif
 	MAKE(8, MASK_7_1, 2, MASK_STEREO, channelmix_f32_7p1_2_c),
 	MAKE(8, MASK_7_1, 4, MASK_QUAD, channelmix_f32_7p1_4_c),
 	MAKE(8, MASK_7_1, 4, MASK_3_1, channelmix_f32_7p1_3p1_c),
 
+#if defined (HAVE_NEON)
+	MAKE(ANY, 0, ANY, 0, channelmix_f32_n_m_neon, SPA_CPU_FLAG_NEON),
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	MAKE(ANY, 0, ANY, 0, channelmix_f32_n_m_avx, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3),
+#endif
 #if defined (HAVE_SSE)
 	MAKE(ANY, 0, ANY, 0, channelmix_f32_n_m_sse, SPA_CPU_FLAG_SSE),
 #endif
@@ -730,9 +755,16 @@ static void impl_channelmix_set_volume(struct channelmix *mix, float volume, boo
 
 	t = 0.0;
 	for (i = 0; i < dst_chan; i++) {
+		struct channelmix_plan *p = &mix->plan[i];
+
+		p->n_src = 0;
 		for (j = 0; j < src_chan; j++) {
 			float v = mix->matrix[i][j];
 			spa_log_debug(mix->log, "%d %d: %f", i, j, v);
+			if (v != 0.0f) {
+				p->src[p->n_src] = j;
+				p->coef[p->n_src++] = v;
+			}
 			if (i == 0 && j == 0)
 				t = v;
 			else if (t != v)
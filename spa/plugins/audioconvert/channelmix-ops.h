@@ -51,6 +51,12 @@ struct channelmix {
 	uint32_t flags;
 	float matrix_orig[SPA_AUDIO_MAX_CHANNELS][SPA_AUDIO_MAX_CHANNELS];
 	float matrix[SPA_AUDIO_MAX_CHANNELS][SPA_AUDIO_MAX_CHANNELS];
+	/* the nonzero coefficients of each row of matrix, made in set_volume */
+	struct channelmix_plan {
+		uint32_t n_src;
+		uint8_t src[SPA_AUDIO_MAX_CHANNELS];
+		float coef[SPA_AUDIO_MAX_CHANNELS];
+	} plan[SPA_AUDIO_MAX_CHANNELS];
 
 	float freq;					/* sample frequency */
 	float lfe_cutoff;				/* in Hz, 0 is disabled */
@@ -137,4 +143,17 @@ DEFINE_FUNCTION(f32_5p1_4, sse);
 DEFINE_FUNCTION(f32_7p1_4, sse);
 #endif
 
+#if defined (HAVE_AVX)
+DEFINE_FUNCTION(copy, avx);
+DEFINE_FUNCTION(f32_n_m, avx);
+DEFINE_FUNCTION(f32_5p1_2, avx);
+DEFINE_FUNCTION(f32_7p1_2, avx);
+#endif
+
+#if defined (HAVE_NEON)
+DEFINE_FUNCTION(copy, neon);
+DEFINE_FUNCTION(f32_n_m, neon);
+DEFINE_FUNCTION(f32_7p1_2, neon);
+#endif
+
 #undef DEFINE_FUNCTION
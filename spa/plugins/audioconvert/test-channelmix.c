@@ -314,7 +314,16 @@ static void run_n_m_impl(struct channelmix *mix, const void **src, uint32_t n_sa
 
 	channelmix_f32_n_m_c(mix, dst_c, src, n_samples);
 
-	channelmix_f32_n_m_c(mix, dst_x, src, n_samples);
+	/* the plan must give the same result as the full matrix */
+	for (i = 0; i < dst_chan; i++) {
+		uint32_t j, k;
+		for (k = 0; k < n_samples; k++) {
+			float sum = 0.0f;
+			for (j = 0; j < mix->src_chan; j++)
+				sum += mix->matrix[i][j] * ((const float*)src[j])[k];
+			dst_x_data[i][k] = sum;
+		}
+	}
 	check_samples((float**)dst_c, (float**)dst_x, dst_chan, n_samples);
 
 #if defined(HAVE_SSE)
@@ -323,6 +332,18 @@ static void run_n_m_impl(struct channelmix *mix, const void **src, uint32_t n_sa
 		check_samples((float**)dst_c, (float**)dst_x, dst_chan, n_samples);
 	}
 #endif
+#if defined(HAVE_AVX) && defined(HAVE_FMA)
+	if (SPA_FLAG_IS_SET(cpu_flags, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3)) {
+		channelmix_f32_n_m_avx(mix, dst_x, src, n_samples);
+		check_samples((float**)dst_c, (float**)dst_x, dst_chan, n_samples);
+	}
+#endif
+#if defined(HAVE_NEON)
+	if (cpu_flags & SPA_CPU_FLAG_NEON) {
+		channelmix_f32_n_m_neon(mix, dst_x, src, n_samples);
+		check_samples((float**)dst_c, (float**)dst_x, dst_chan, n_samples);
+	}
+#endif
 }
 
 static void test_n_m_impl(void)
@@ -357,6 +378,16 @@ static void test_n_m_impl(void)
 	channelmix_set_volume(&mix, 1.0f, false, 0, NULL);
 	run_n_m_impl(&mix, (const void**)src, N_SAMPLES);
 
+	/* sparse routing, a permutation with some gains and one sum */
+	for (i = 0; i < mix.dst_chan; i++) {
+		for (j = 0; j < mix.src_chan; j++)
+			mix.matrix_orig[i][j] = 0.0f;
+		mix.matrix_orig[i][(i * 5 + 3) % mix.src_chan] = i & 1 ? 0.5f : 1.0f;
+	}
+	mix.matrix_orig[4][15] = 0.25f;
+	channelmix_set_volume(&mix, 1.0f, false, 0, NULL);
+	run_n_m_impl(&mix, (const void**)src, N_SAMPLES);
+
 	/* random matrix */
 	for (i = 0; i < mix.dst_chan; i++) {
 		for (j = 0; j < mix.src_chan; j++) {
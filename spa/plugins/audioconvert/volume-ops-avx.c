@@ -0,0 +1,47 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include "volume-ops.h"
+
+#include <immintrin.h>
+
+void
+volume_f32_avx(struct volume *vol, void * SPA_RESTRICT dst,
+		const void * SPA_RESTRICT src, float volume, uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	float *d = (float*)dst;
+	const float *s = (const float*)src;
+
+	if (volume == VOLUME_MIN) {
+		memset(d, 0, n_samples * sizeof(float));
+	}
+	else if (volume == VOLUME_NORM) {
+		spa_memcpy(d, s, n_samples * sizeof(float));
+	}
+	else {
+		__m256 t[4];
+		const __m256 vol = _mm256_set1_ps(volume);
+
+		if (SPA_IS_ALIGNED(d, 32) &&
+		    SPA_IS_ALIGNED(s, 32))
+			unrolled = n_samples & ~31;
+		else
+			unrolled = 0;
+
+		for(n = 0; n < unrolled; n += 32) {
+			t[0] = _mm256_load_ps(&s[n]);
+			t[1] = _mm256_load_ps(&s[n+8]);
+			t[2] = _mm256_load_ps(&s[n+16]);
+			t[3] = _mm256_load_ps(&s[n+24]);
+			_mm256_store_ps(&d[n], _mm256_mul_ps(t[0], vol));
+			_mm256_store_ps(&d[n+8], _mm256_mul_ps(t[1], vol));
+			_mm256_store_ps(&d[n+16], _mm256_mul_ps(t[2], vol));
+			_mm256_store_ps(&d[n+24], _mm256_mul_ps(t[3], vol));
+		}
+		for(; n < n_samples; n++)
+			_mm_store_ss(&d[n], _mm_mul_ss(_mm_load_ss(&s[n]),
+						_mm256_castps256_ps128(vol)));
+	}
+}
@@ -0,0 +1,41 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include "volume-ops.h"
+
+#include <arm_neon.h>
+
+void
+volume_f32_neon(struct volume *vol, void * SPA_RESTRICT dst,
+		const void * SPA_RESTRICT src, float volume, uint32_t n_samples)
+{
+	uint32_t n, unrolled;
+	float *d = (float*)dst;
+	const float *s = (const float*)src;
+
+	if (volume == VOLUME_MIN) {
+		memset(d, 0, n_samples * sizeof(float));
+	}
+	else if (volume == VOLUME_NORM) {
+		spa_memcpy(d, s, n_samples * sizeof(float));
+	}
+	else {
+		const float32x4_t vol = vdupq_n_f32(volume);
+
+		unrolled = n_samples & ~15;
+
+		for(n = 0; n < unrolled; n += 16) {
+			float32x4_t t0 = vld1q_f32(&s[n]);
+			float32x4_t t1 = vld1q_f32(&s[n+4]);
+			float32x4_t t2 = vld1q_f32(&s[n+8]);
+			float32x4_t t3 = vld1q_f32(&s[n+12]);
+			vst1q_f32(&d[n], vmulq_f32(t0, vol));
+			vst1q_f32(&d[n+4], vmulq_f32(t1, vol));
+			vst1q_f32(&d[n+8], vmulq_f32(t2, vol));
+			vst1q_f32(&d[n+12], vmulq_f32(t3, vol));
+		}
+		for(; n < n_samples; n++)
+			d[n] = s[n] * volume;
+	}
+}
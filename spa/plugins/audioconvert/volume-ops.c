@@ -25,6 +25,12 @@ static const struct volume_info {
 	uint32_t cpu_flags;
 } volume_table[] =
 {
+#if defined (HAVE_NEON)
+	MAKE(volume_f32_neon, SPA_CPU_FLAG_NEON),
+#endif
+#if defined (HAVE_AVX) && defined (HAVE_FMA)
+	MAKE(volume_f32_avx, SPA_CPU_FLAG_AVX | SPA_CPU_FLAG_FMA3),
+#endif
 #if defined (HAVE_SSE)
 	MAKE(volume_f32_sse, SPA_CPU_FLAG_SSE),
 #endif
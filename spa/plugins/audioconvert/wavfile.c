@@ -41,6 +41,8 @@ struct wav_file {
 
 	uint32_t stride;
 	uint32_t blocks;
+
+	bool read;
 };
 
 static inline ssize_t write_data(struct wav_file *wf, const void *data, size_t size)
@@ -165,6 +167,108 @@ static int write_headers(struct wav_file *wf)
 	return 0;
 }
 
+static inline int read_n(int fd, void *buf, int count)
+{
+	return read(fd, buf, count) == (ssize_t)count ? count : -EIO;
+}
+
+static inline int read_le16(int fd, uint16_t *val)
+{
+	uint8_t buf[2];
+	int res;
+	if ((res = read_n(fd, buf, 2)) < 0)
+		return res;
+	*val = buf[0] | (buf[1] << 8);
+	return res;
+}
+
+static inline int read_le32(int fd, uint32_t *val)
+{
+	uint8_t buf[4];
+	int res;
+	if ((res = read_n(fd, buf, 4)) < 0)
+		return res;
+	*val = buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+	return res;
+}
+
+static int read_headers(struct wav_file *wf)
+{
+	int res;
+	char id[4];
+	uint32_t size, rate = 0, bps;
+	uint16_t fmt = 0, channels = 0, bpb, bits = 0;
+	uint32_t i;
+
+	CHECK_RES(read_n(wf->fd, id, 4));
+	if (memcmp(id, "RIFF", 4) != 0)
+		return -EINVAL;
+	CHECK_RES(read_le32(wf->fd, &size));
+	CHECK_RES(read_n(wf->fd, id, 4));
+	if (memcmp(id, "WAVE", 4) != 0)
+		return -EINVAL;
+
+	while (true) {
+		CHECK_RES(read_n(wf->fd, id, 4));
+		CHECK_RES(read_le32(wf->fd, &size));
+
+		if (memcmp(id, "fmt ", 4) == 0) {
+			if (size < 16)
+				return -EINVAL;
+			CHECK_RES(read_le16(wf->fd, &fmt));
+			CHECK_RES(read_le16(wf->fd, &channels));
+			CHECK_RES(read_le32(wf->fd, &rate));
+			CHECK_RES(read_le32(wf->fd, &bps));
+			CHECK_RES(read_le16(wf->fd, &bpb));
+			CHECK_RES(read_le16(wf->fd, &bits));
+			size -= 16;
+		} else if (memcmp(id, "data", 4) == 0) {
+			wf->length = size;
+			break;
+		}
+		/* skip the rest of the chunk, chunks are padded to even sizes */
+		if (lseek(wf->fd, size + (size & 1), SEEK_CUR) < 0)
+			return -errno;
+	}
+	if (channels == 0 || rate == 0)
+		return -EINVAL;
+
+	for (i = 0; i < SPA_N_ELEMENTS(format_info); i++) {
+		const struct format_info *fi = &format_info[i];
+		if (!fi->planar && fi->fmt == fmt && fi->bits == bits) {
+			wf->fi = fi;
+			break;
+		}
+	}
+	if (wf->fi == NULL)
+		return -ENOTSUP;
+
+	wf->info.media_type = SPA_MEDIA_TYPE_audio;
+	wf->info.media_subtype = SPA_MEDIA_SUBTYPE_raw;
+	wf->info.info.raw.format = wf->fi->format;
+	wf->info.info.raw.rate = rate;
+	wf->info.info.raw.channels = channels;
+	wf->stride = channels * (bits / 8);
+	wf->blocks = 1;
+	return 0;
+}
+
+static int open_read(struct wav_file *wf, const char *filename, struct wav_file_info *info)
+{
+	int res;
+
+	if ((wf->fd = open(filename, O_RDONLY | O_CLOEXEC)) < 0)
+		return -errno;
+
+	wf->read = true;
+	if ((res = read_headers(wf)) < 0) {
+		close(wf->fd);
+		return res;
+	}
+	info->info = wf->info;
+	return 0;
+}
+
 static const struct format_info *find_info(struct wav_file_info *info)
 {
 	uint32_t i;
@@ -221,6 +325,9 @@ wav_file_open(const char *filename, const char *mode, struct wav_file_info *info
 	if (spa_streq(mode, "w")) {
 		if ((res = open_write(wf, filename, info)) < 0)
 			goto exit_free;
+	} else if (spa_streq(mode, "r")) {
+		if ((res = open_read(wf, filename, info)) < 0)
+			goto exit_free;
 	} else {
 		res = -EINVAL;
 		goto exit_free;
@@ -237,7 +344,8 @@ int wav_file_close(struct wav_file *wf)
 {
 	int res;
 
-	CHECK_RES(write_headers(wf));
+	if (!wf->read)
+		CHECK_RES(write_headers(wf));
 
 	close(wf->fd);
 	free(wf);
@@ -248,3 +356,16 @@ ssize_t wav_file_write(struct wav_file *wf, const void **data, size_t samples)
 {
 	return wf->fi->write(wf, data, samples);
 }
+
+ssize_t wav_file_read(struct wav_file *wf, void *data, size_t samples)
+{
+	ssize_t len;
+
+	samples = SPA_MIN(samples, wf->length / wf->stride);
+	if (samples == 0)
+		return 0;
+	if ((len = read(wf->fd, data, samples * wf->stride)) < 0)
+		return -errno;
+	wf->length -= len;
+	return len / wf->stride;
+}
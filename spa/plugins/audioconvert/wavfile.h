@@ -37,3 +37,7 @@ wav_file_open(const char *filename, const char *mode, struct wav_file_info *info
 int wav_file_close(struct wav_file *wf);
 
 ssize_t wav_file_write(struct wav_file *wf, const void **data, size_t size);
+
+/** read at most samples interleaved frames in the format of the file,
+ * returns the number of frames read, 0 at the end of the file */
+ssize_t wav_file_read(struct wav_file *wf, void *data, size_t samples);
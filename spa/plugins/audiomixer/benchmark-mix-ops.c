@@ -11,6 +11,8 @@
 #include <errno.h>
 #include <time.h>
 
+#include <spa/param/audio/raw.h>
+
 #include "test-helper.h"
 #include "mix-ops.h"
 
@@ -27,7 +29,7 @@ struct stats {
 };
 
 #define MAX_SAMPLES	4096
-#define MAX_SRC		11
+#define MAX_SRC		32
 
 #define MAX_COUNT 100
 
@@ -36,6 +38,7 @@ static uint8_t samp_out[MAX_SAMPLES * 8];
 
 static const int sample_sizes[] = { 0, 1, 128, 513, 4096 };
 static const int src_counts[] = { 1, 2, 4, 6, 8, 11 };
+static const int port_sizes[] = { 64, 256, 1024 };
 
 #define MAX_RESULTS	SPA_N_ELEMENTS(sample_sizes) * SPA_N_ELEMENTS(src_counts) * 70
 
@@ -160,6 +163,28 @@ static void test_f64(void)
 #endif
 }
 
+/* the mixing of peers into a JACK input port, with the implementation selected
+ * by mix_ops_init() like pipewire-jack does */
+static void test_f32_port(void)
+{
+	struct mix_ops mix;
+	size_t i;
+	int j;
+
+	spa_zero(mix);
+	mix.fmt = SPA_AUDIO_FORMAT_F32P;
+	mix.n_channels = 1;
+	mix.cpu_flags = cpu_flags;
+	if (mix_ops_init(&mix) < 0)
+		return;
+
+	for (i = 0; i < SPA_N_ELEMENTS(port_sizes); i++) {
+		for (j = 1; j <= MAX_SRC; j++)
+			run_test1("test_f32_port", "dispatch", mix.process, j, port_sizes[i]);
+	}
+	mix_ops_free(&mix);
+}
+
 static int compare_func(const void *_a, const void *_b)
 {
 	const struct stats *a = _a, *b = _b;
@@ -190,6 +215,7 @@ int main(int argc, char *argv[])
 	test_u24_32();
 	test_f32();
 	test_f64();
+	test_f32_port();
 
 	qsort(results, n_results, sizeof(struct stats), compare_func);
 
@@ -0,0 +1,128 @@
+/* Spa */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <assert.h>
+
+#include <spa/utils/json.h>
+#include <spa/utils/string.h>
+
+#define MAX_COUNT 20
+#define MAX_SIZE (4 * 1024 * 1024)
+
+static char data[MAX_SIZE];
+
+/* a filter-chain graph with large IR arrays */
+static int gen_filter_graph(char *str, size_t size)
+{
+	struct spa_strbuf buf;
+	uint32_t i, j;
+	char f[64];
+
+	spa_strbuf_init(&buf, str, size);
+	spa_strbuf_append(&buf, "filter.graph = {\n    nodes = [\n");
+	for (i = 0; i < 16; i++) {
+		spa_strbuf_append(&buf,
+				"        {\n"
+				"            type = builtin\n"
+				"            name = convolver%u\n"
+				"            label = convolver\n"
+				"            config = {\n"
+				"                gain = 1.0\n"
+				"                ir = [\n", i);
+		for (j = 0; j < 4096; j++)
+			spa_strbuf_append(&buf, "                    %s,\n",
+					spa_json_format_float(f, sizeof(f),
+						(float)(drand48() * 2.0 - 1.0)));
+		spa_strbuf_append(&buf,
+				"                ]\n"
+				"            }\n"
+				"        }\n");
+	}
+	spa_strbuf_append(&buf, "    ]\n}\n");
+	return buf.pos;
+}
+
+/* a metadata blob with long strings */
+static int gen_metadata(char *str, size_t size)
+{
+	struct spa_strbuf buf;
+	uint32_t i;
+
+	spa_strbuf_init(&buf, str, size);
+	spa_strbuf_append(&buf, "[");
+	for (i = 0; i < 8192; i++) {
+		spa_strbuf_append(&buf,
+				"{ \"subject\": %u, \"key\": \"default.configured.audio.sink\", "
+				"\"type\": \"Spa:String:JSON\", \"value\": { \"name\": "
+				"\"alsa_output.pci-0000_00_1f.3.analog-stereo.monitor-%u\" } },\n", i, i);
+	}
+	spa_strbuf_append(&buf, "]");
+	return buf.pos;
+}
+
+static uint32_t walk(struct spa_json *iter, float *sum)
+{
+	const char *value;
+	uint32_t count = 0;
+	int len;
+	float f;
+
+	while ((len = spa_json_next(iter, &value)) > 0) {
+		count++;
+		if (spa_json_is_container(value, len)) {
+			struct spa_json sub;
+			spa_json_enter(iter, &sub);
+			count += walk(&sub, sum);
+		} else if (spa_json_parse_float(value, len, &f) > 0) {
+			*sum += f;
+		}
+	}
+	return count;
+}
+
+static void test_parse(const char *name, const char *str, int len)
+{
+	struct timespec ts;
+	struct spa_json it;
+	uint64_t t1, t2;
+	uint32_t i, count = 0;
+	float sum = 0.0f;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t1 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+	for (i = 0; i < MAX_COUNT; i++) {
+		spa_json_init(&it, str, len);
+		count = walk(&it, &sum);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t2 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+	fprintf(stderr, "%s: %d bytes, %u tokens, elapsed %"PRIu64" = %.1f MB/sec (%f)\n",
+			name, len, count, (t2 - t1) / MAX_COUNT,
+			(double)len * MAX_COUNT * SPA_NSEC_PER_SEC / (t2 - t1) / (1024 * 1024),
+			sum);
+}
+
+int main(int argc, char *argv[])
+{
+	int len;
+
+	srand48(0);
+
+	len = gen_filter_graph(data, sizeof(data));
+	assert((size_t)len < sizeof(data));
+	test_parse("filter-graph", data, len);
+
+	len = gen_metadata(data, sizeof(data));
+	assert((size_t)len < sizeof(data));
+	test_parse("metadata", data, len);
+
+	return 0;
+}
@@ -12,6 +12,7 @@
 #include <spa/pod/pod.h>
 #include <spa/pod/builder.h>
 #include <spa/pod/parser.h>
+#include <spa/pod/filter.h>
 #include <spa/param/video/format-utils.h>
 #include <spa/debug/pod.h>
 
@@ -264,11 +265,124 @@ static void test_parser(void)
 			t2 - t1, count, count * (uint64_t)SPA_NSEC_PER_SEC / (t2 - t1));
 }
 
+static struct spa_pod *build_video_format(struct spa_pod_builder *b, uint32_t format,
+		uint32_t n_sizes, const struct spa_rectangle *sizes,
+		uint32_t n_rates, const struct spa_fraction *rates)
+{
+	struct spa_pod_frame f[2];
+	uint32_t i;
+
+	spa_pod_builder_push_object(b, &f[0], SPA_TYPE_OBJECT_Format, SPA_PARAM_EnumFormat);
+	spa_pod_builder_add(b,
+			SPA_FORMAT_mediaType,	    SPA_POD_Id(SPA_MEDIA_TYPE_video),
+			SPA_FORMAT_mediaSubtype,    SPA_POD_Id(SPA_MEDIA_SUBTYPE_raw),
+			SPA_FORMAT_VIDEO_format,    SPA_POD_Id(format),
+			0);
+	spa_pod_builder_prop(b, SPA_FORMAT_VIDEO_size, 0);
+	spa_pod_builder_push_choice(b, &f[1], SPA_CHOICE_Enum, 0);
+	spa_pod_builder_rectangle(b, sizes[0].width, sizes[0].height);
+	for (i = 0; i < n_sizes; i++)
+		spa_pod_builder_rectangle(b, sizes[i].width, sizes[i].height);
+	spa_pod_builder_pop(b, &f[1]);
+	spa_pod_builder_prop(b, SPA_FORMAT_VIDEO_framerate, 0);
+	spa_pod_builder_push_choice(b, &f[1], SPA_CHOICE_Enum, 0);
+	spa_pod_builder_fraction(b, rates[0].num, rates[0].denom);
+	for (i = 0; i < n_rates; i++)
+		spa_pod_builder_fraction(b, rates[i].num, rates[i].denom);
+	spa_pod_builder_pop(b, &f[1]);
+	spa_pod_builder_add(b,
+			SPA_FORMAT_VIDEO_pixelAspectRatio, SPA_POD_CHOICE_RANGE_Fraction(
+							&SPA_FRACTION(1,1),
+							&SPA_FRACTION(0,1),
+							&SPA_FRACTION(INT32_MAX,1)),
+			0);
+	return spa_pod_builder_pop(b, &f[0]);
+}
+
+static const struct spa_rectangle camera_sizes[] = {
+	{ 160, 120 }, { 176, 144 }, { 320, 180 }, { 320, 240 }, { 352, 288 },
+	{ 424, 240 }, { 640, 360 }, { 640, 480 }, { 800, 448 }, { 800, 600 },
+	{ 848, 480 }, { 960, 540 }, { 1024, 576 }, { 1280, 720 }, { 1600, 896 },
+	{ 1920, 1080 },
+};
+static const struct spa_fraction camera_rates[] = {
+	{ 60, 1 }, { 50, 1 }, { 30, 1 }, { 25, 1 }, { 24, 1 }, { 20, 1 },
+	{ 15, 1 }, { 10, 1 }, { 15, 2 }, { 5, 1 },
+};
+static const struct spa_rectangle sink_sizes[] = {
+	{ 640, 480 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 },
+};
+static const struct spa_fraction sink_rates[] = {
+	{ 30, 1 }, { 25, 1 }, { 60, 1 },
+};
+
+static void test_filter(bool indexed)
+{
+	uint8_t buffer[4096], result[4096];
+	struct spa_pod_builder b = { NULL, }, rb = { NULL, };
+	struct spa_pod *formats[4], *filter, *res;
+	struct spa_pod_index iformats[4], ifilter;
+	struct timespec ts;
+	uint64_t t1, t2;
+	uint64_t count = 0;
+	uint32_t i;
+	int n_ok;
+
+	spa_pod_builder_init(&b, buffer, sizeof(buffer));
+	formats[0] = build_video_format(&b, SPA_VIDEO_FORMAT_YUY2,
+			SPA_N_ELEMENTS(camera_sizes), camera_sizes,
+			SPA_N_ELEMENTS(camera_rates), camera_rates);
+	formats[1] = build_video_format(&b, SPA_VIDEO_FORMAT_NV12,
+			SPA_N_ELEMENTS(camera_sizes), camera_sizes,
+			SPA_N_ELEMENTS(camera_rates), camera_rates);
+	formats[2] = build_video_format(&b, SPA_VIDEO_FORMAT_I420,
+			SPA_N_ELEMENTS(camera_sizes), camera_sizes,
+			SPA_N_ELEMENTS(camera_rates), camera_rates);
+	formats[3] = build_video_format(&b, SPA_VIDEO_FORMAT_RGB,
+			SPA_N_ELEMENTS(camera_sizes) / 2, camera_sizes,
+			SPA_N_ELEMENTS(camera_rates) / 2, camera_rates);
+	filter = build_video_format(&b, SPA_VIDEO_FORMAT_I420,
+			SPA_N_ELEMENTS(sink_sizes), sink_sizes,
+			SPA_N_ELEMENTS(sink_rates), sink_rates);
+
+	for (i = 0; i < 4; i++)
+		spa_assert_se(spa_pod_index_init(&iformats[i], formats[i]) == 0);
+	spa_assert_se(spa_pod_index_init(&ifilter, filter) == 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t1 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+	fprintf(stderr, "test_filter%s() : ", indexed ? "_index" : "");
+	for (count = 0; count < MAX_COUNT; count++) {
+		n_ok = 0;
+		for (i = 0; i < 4; i++) {
+			spa_pod_builder_init(&rb, result, sizeof(result));
+			if (indexed) {
+				if (spa_pod_filter_index(&rb, &res, &iformats[i], &ifilter) >= 0)
+					n_ok++;
+			} else {
+				if (spa_pod_filter(&rb, &res, formats[i], filter) >= 0)
+					n_ok++;
+			}
+		}
+		spa_assert(n_ok == 1);
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		t2 = SPA_TIMESPEC_TO_NSEC(&ts);
+		if (t2 - t1 > 1 * SPA_NSEC_PER_SEC)
+			break;
+	}
+	fprintf(stderr, "elapsed %"PRIu64" count %"PRIu64" = %"PRIu64"/sec\n",
+			t2 - t1, count, count * (uint64_t)SPA_NSEC_PER_SEC / (t2 - t1));
+}
+
 int main(int argc, char *argv[])
 {
 	test_builder();
 	test_builder2();
 	test_parse();
 	test_parser();
+	test_filter(false);
+	test_filter(true);
 	return 0;
 }
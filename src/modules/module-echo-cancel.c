@@ -10,6 +10,8 @@
 #include <getopt.h>
 #include <limits.h>
 #include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -25,6 +27,7 @@
 #include <spa/pod/builder.h>
 #include <spa/pod/dynamic.h>
 #include <spa/support/plugin.h>
+#include <spa/utils/atomic.h>
 #include <spa/utils/json.h>
 #include <spa/utils/names.h>
 #include <spa/utils/result.h>
@@ -37,6 +40,7 @@
 
 #include <pipewire/impl.h>
 #include <pipewire/pipewire.h>
+#include <pipewire/thread.h>
 
 #include <pipewire/extensions/profiler.h>
 
@@ -91,6 +95,10 @@
  * - `library.name = <str>`: the echo cancellation library  Currently supported:
  * `aec/libspa-aec-webrtc`. Leave unset to use the default method (`aec/libspa-aec-webrtc`).
  * - `aec.args = <str>`: arguments to pass to the echo cancellation method
+ * - `aec.worker = <bool>`: run the echo canceller in a separate thread. The
+ *                   data thread then only copies samples to and from ring
+ *                   buffers and the cost of the canceller is spread over the
+ *                   cycles. This adds one AEC block of latency. Default false.
  * - `monitor.mode`: Instead of making a sink, make a stream that captures from
  *                   the monitor ports of the default sink.
  *
@@ -119,6 +127,7 @@
  *          # library.name  = aec/libspa-aec-webrtc
  *          # node.latency = 1024/48000
  *          # monitor.mode = false
+ *          # aec.worker = false
  *          capture.props = {
  *             node.name = "Echo Cancellation Capture"
  *          }
@@ -166,6 +175,7 @@ static const struct spa_dict_item module_props[] = {
 				"( buffer.play_delay=<delay as fraction> ) "
 				"( library.name =<library name> ) "
 				"( aec.args=<aec arguments> ) "
+				"( aec.worker=<run the canceller in a thread> ) "
 				"( capture.props=<properties> ) "
 				"( source.props=<properties> ) "
 				"( sink.props=<properties> ) "
@@ -175,6 +185,7 @@ static const struct spa_dict_item module_props[] = {
 
 struct impl {
 	struct pw_context *context;
+	struct pw_data_loop *data_loop;
 
 	struct pw_impl_module *module;
 	struct spa_hook module_listener;
@@ -222,6 +233,14 @@ struct impl {
 	struct spa_audio_aec *aec;
 	uint32_t aec_blocksize;
 
+	bool use_worker;
+	bool worker_running;
+	struct spa_thread *worker;
+	sem_t worker_wakeup;
+	pthread_mutex_t worker_lock;
+	uint32_t worker_blocksize;
+	float *worker_data;
+
 	unsigned int capture_ready:1;
 	unsigned int sink_ready:1;
 
@@ -285,9 +304,237 @@ static inline void aec_run(struct impl *impl, const float *rec[], const float *p
 	}
 }
 
-static void process(struct impl *impl)
+/* runs the canceller on one block of size bytes, the first part of the
+ * output is silence until the playback delay has been filled. */
+static void run_canceller(struct impl *impl, const float *rec[], const float *play_delayed[],
+		float *out[], uint32_t size)
+{
+	uint32_t i;
+
+	if (SPA_UNLIKELY (impl->current_delay < impl->buffer_delay)) {
+		uint32_t delay_left = impl->buffer_delay - impl->current_delay;
+		uint32_t silence_size;
+
+		/* don't run the canceller until play_buffer has been filled,
+		 * copy silence to output in the meantime */
+		silence_size = SPA_MIN(size, delay_left * sizeof(float));
+		for (i = 0; i < impl->out_info.channels; i++)
+			memset(out[i], 0, silence_size);
+		impl->current_delay += silence_size / sizeof(float);
+		pw_log_debug("current_delay %d", impl->current_delay);
+
+		if (silence_size != size) {
+			const float *pd[impl->play_info.channels];
+			float *o[impl->out_info.channels];
+
+			for (i = 0; i < impl->play_info.channels; i++)
+				pd[i] = play_delayed[i] + delay_left;
+			for (i = 0; i < impl->out_info.channels; i++)
+				o[i] = out[i] + delay_left;
+
+			aec_run(impl, rec, pd, o, size / sizeof(float) - delay_left);
+		}
+	} else {
+		/* run the canceller */
+		aec_run(impl, rec, play_delayed, out, size / sizeof(float));
+	}
+}
+
+/* takes blocks of size bytes from the output ringbuffer and makes them
+ * available on the source */
+static void flush_source(struct impl *impl, uint32_t size)
 {
 	struct pw_buffer *cout;
+	struct spa_data *dd;
+	uint32_t i, oindex;
+	int32_t avail;
+
+	if (size == 0)
+		return;
+
+	avail = spa_ringbuffer_get_read_index(&impl->out_ring, &oindex);
+	while (avail >= (int32_t)size) {
+		if ((cout = pw_stream_dequeue_buffer(impl->source)) == NULL) {
+			pw_log_debug("out of source buffers: %m");
+			break;
+		}
+
+		for (i = 0; i < impl->out_info.channels; i++) {
+			dd = &cout->buffer->datas[i];
+			spa_ringbuffer_read_data(&impl->out_ring, impl->out_buffer[i],
+					impl->out_ringsize, oindex % impl->out_ringsize,
+					(void *)dd->data, size);
+			dd->chunk->offset = 0;
+			dd->chunk->size = size;
+			dd->chunk->stride = sizeof(float);
+		}
+
+		pw_stream_queue_buffer(impl->source, cout);
+
+		oindex += size;
+		spa_ringbuffer_read_update(&impl->out_ring, oindex);
+		avail -= size;
+	}
+}
+
+/* with the worker, the data thread only passes the sink data to the
+ * playback stream in blocks of size bytes */
+static void flush_playback(struct impl *impl, uint32_t size)
+{
+	struct pw_buffer *pout;
+	struct spa_data *dd;
+	uint32_t i, pindex;
+	int32_t avail;
+
+	if (size == 0)
+		return;
+
+	avail = spa_ringbuffer_get_read_index(&impl->play_ring, &pindex);
+	while (avail >= (int32_t)size) {
+		if (impl->playback != NULL) {
+			if ((pout = pw_stream_dequeue_buffer(impl->playback)) == NULL) {
+				pw_log_debug("out of playback buffers: %m");
+				break;
+			}
+			for (i = 0; i < impl->play_info.channels; i++) {
+				dd = &pout->buffer->datas[i];
+				spa_ringbuffer_read_data(&impl->play_ring, impl->play_buffer[i],
+						impl->play_ringsize, pindex % impl->play_ringsize,
+						dd->data, size);
+				dd->chunk->offset = 0;
+				dd->chunk->size = size;
+				dd->chunk->stride = sizeof(float);
+			}
+			pw_stream_queue_buffer(impl->playback, pout);
+		}
+		pindex += size;
+		spa_ringbuffer_read_update(&impl->play_ring, pindex);
+		avail -= size;
+	}
+}
+
+/* run the canceller on one block in the worker thread. The worker is the
+ * only reader of rec_ring and play_delayed_ring and the only writer of
+ * out_ring so that all rings stay single producer, single consumer. */
+static int worker_process_block(struct impl *impl)
+{
+	uint32_t i, size = impl->aec_blocksize;
+	uint32_t rindex, pdindex, oindex;
+	int32_t avail;
+	const float *rec[impl->rec_info.channels];
+	const float *play_delayed[impl->play_info.channels];
+	float *out[impl->out_info.channels];
+	float *data;
+
+	if (size == 0)
+		return 0;
+
+	if (spa_ringbuffer_get_read_index(&impl->rec_ring, &rindex) < (int32_t)size ||
+	    spa_ringbuffer_get_read_index(&impl->play_delayed_ring, &pdindex) < (int32_t)size)
+		return 0;
+
+	if (impl->worker_blocksize != size) {
+		uint32_t n_channels = impl->rec_info.channels +
+			impl->play_info.channels + impl->out_info.channels;
+
+		data = realloc(impl->worker_data, n_channels * size);
+		if (data == NULL) {
+			pw_log_error("can't allocate AEC blocks: %m");
+			return -errno;
+		}
+		impl->worker_data = data;
+		impl->worker_blocksize = size;
+	}
+	data = impl->worker_data;
+
+	for (i = 0; i < impl->rec_info.channels; i++) {
+		spa_ringbuffer_read_data(&impl->rec_ring, impl->rec_buffer[i],
+				impl->rec_ringsize, rindex % impl->rec_ringsize,
+				data, size);
+		rec[i] = data;
+		data = SPA_PTROFF(data, size, float);
+	}
+	spa_ringbuffer_read_update(&impl->rec_ring, rindex + size);
+
+	for (i = 0; i < impl->play_info.channels; i++) {
+		spa_ringbuffer_read_data(&impl->play_delayed_ring, impl->play_buffer[i],
+				impl->play_ringsize, pdindex % impl->play_ringsize,
+				data, size);
+		play_delayed[i] = data;
+		data = SPA_PTROFF(data, size, float);
+	}
+	spa_ringbuffer_read_update(&impl->play_delayed_ring, pdindex + size);
+
+	for (i = 0; i < impl->out_info.channels; i++) {
+		out[i] = data;
+		data = SPA_PTROFF(data, size, float);
+	}
+
+	run_canceller(impl, rec, play_delayed, out, size);
+
+	avail = spa_ringbuffer_get_write_index(&impl->out_ring, &oindex);
+	if (avail + size > impl->out_ringsize) {
+		/* the data thread owns the read side, drop this block */
+		pw_log_debug("output ringbuffer xrun %d + %u > %u, dropping block",
+				avail, size, impl->out_ringsize);
+		return 1;
+	}
+	for (i = 0; i < impl->out_info.channels; i++) {
+		spa_ringbuffer_write_data(&impl->out_ring, impl->out_buffer[i],
+				impl->out_ringsize, oindex % impl->out_ringsize,
+				out[i], size);
+	}
+	spa_ringbuffer_write_update(&impl->out_ring, oindex + size);
+	return 1;
+}
+
+static void *worker_thread(void *data)
+{
+	struct impl *impl = data;
+
+	while (true) {
+		while (sem_wait(&impl->worker_wakeup) < 0 && errno == EINTR);
+		if (!SPA_ATOMIC_LOAD(impl->worker_running))
+			break;
+
+		pthread_mutex_lock(&impl->worker_lock);
+		while (worker_process_block(impl) > 0);
+		pthread_mutex_unlock(&impl->worker_lock);
+	}
+	return NULL;
+}
+
+static int start_worker(struct impl *impl)
+{
+	sem_init(&impl->worker_wakeup, 0, 0);
+	SPA_ATOMIC_STORE(impl->worker_running, true);
+
+	impl->worker = pw_thread_utils_create(NULL, worker_thread, impl);
+	if (impl->worker == NULL) {
+		int res = -errno;
+		pw_log_error("can't create AEC worker thread: %m");
+		SPA_ATOMIC_STORE(impl->worker_running, false);
+		sem_destroy(&impl->worker_wakeup);
+		return res;
+	}
+	pw_thread_utils_acquire_rt(impl->worker, -1);
+	return 0;
+}
+
+static void stop_worker(struct impl *impl)
+{
+	if (impl->worker == NULL)
+		return;
+
+	SPA_ATOMIC_STORE(impl->worker_running, false);
+	sem_post(&impl->worker_wakeup);
+	pw_thread_utils_join(impl->worker, NULL);
+	impl->worker = NULL;
+	sem_destroy(&impl->worker_wakeup);
+}
+
+static void process(struct impl *impl)
+{
 	struct pw_buffer *pout = NULL;
 	float rec_buf[impl->rec_info.channels][impl->aec_blocksize / sizeof(float)];
 	float play_buf[impl->play_info.channels][impl->aec_blocksize / sizeof(float)];
@@ -360,33 +607,7 @@ static void process(struct impl *impl)
 	if (impl->playback != NULL)
 		pw_stream_queue_buffer(impl->playback, pout);
 
-	if (SPA_UNLIKELY (impl->current_delay < impl->buffer_delay)) {
-		uint32_t delay_left = impl->buffer_delay - impl->current_delay;
-		uint32_t silence_size;
-
-		/* don't run the canceller until play_buffer has been filled,
-		 * copy silence to output in the meantime */
-		silence_size = SPA_MIN(size, delay_left * sizeof(float));
-		for (i = 0; i < impl->out_info.channels; i++)
-			memset(out[i], 0, silence_size);
-		impl->current_delay += silence_size / sizeof(float);
-		pw_log_debug("current_delay %d", impl->current_delay);
-
-		if (silence_size != size) {
-			const float *pd[impl->play_info.channels];
-			float *o[impl->out_info.channels];
-
-			for (i = 0; i < impl->play_info.channels; i++)
-				pd[i] = play_delayed[i] + delay_left;
-			for (i = 0; i < impl->out_info.channels; i++)
-				o[i] = out[i] + delay_left;
-
-			aec_run(impl, rec, pd, o, size / sizeof(float) - delay_left);
-		}
-	} else {
-		/* run the canceller */
-		aec_run(impl, rec, play_delayed, out, size / sizeof(float));
-	}
+	run_canceller(impl, rec, play_delayed, out, size);
 
 	/* Next, copy over the output to the output ringbuffer */
 	avail = spa_ringbuffer_get_write_index(&impl->out_ring, &oindex);
@@ -415,30 +636,7 @@ static void process(struct impl *impl)
 
 	/* And finally take data from the output ringbuffer and make it
 	 * available on the source */
-
-	avail = spa_ringbuffer_get_read_index(&impl->out_ring, &oindex);
-	while (avail >= size) {
-		if ((cout = pw_stream_dequeue_buffer(impl->source)) == NULL) {
-			pw_log_debug("out of source buffers: %m");
-			break;
-		}
-
-		for (i = 0; i < impl->out_info.channels; i++) {
-			dd = &cout->buffer->datas[i];
-			spa_ringbuffer_read_data(&impl->out_ring, impl->out_buffer[i],
-					impl->out_ringsize, oindex % impl->out_ringsize,
-					(void *)dd->data, size);
-			dd->chunk->offset = 0;
-			dd->chunk->size = size;
-			dd->chunk->stride = sizeof(float);
-		}
-
-		pw_stream_queue_buffer(impl->source, cout);
-
-		oindex += size;
-		spa_ringbuffer_read_update(&impl->out_ring, oindex);
-		avail -= size;
-	}
+	flush_source(impl, size);
 
 done:
 	impl->sink_ready = false;
@@ -474,6 +672,13 @@ static void capture_process(void *data)
 	if (avail + size > impl->rec_ringsize) {
 		uint32_t rindex, drop;
 
+		if (impl->use_worker) {
+			/* the worker owns the read index, drop the new data */
+			pw_log_debug("capture ringbuffer xrun %d + %u > %u, dropping %u",
+					avail, size, impl->rec_ringsize, size);
+			goto done;
+		}
+
 		/* Drop enough so we have size bytes left */
 		drop = avail + size - impl->rec_ringsize;
 		pw_log_debug("capture ringbuffer xrun %d + %u > %u, dropping %u",
@@ -507,11 +712,16 @@ static void capture_process(void *data)
 
 	spa_ringbuffer_write_update(&impl->rec_ring, index + size);
 
-	if (avail + size >= impl->aec_blocksize) {
+	if (impl->use_worker) {
+		sem_post(&impl->worker_wakeup);
+	} else if (avail + size >= impl->aec_blocksize) {
 		impl->capture_ready = true;
 		if (impl->sink_ready)
 			process(impl);
 	}
+done:
+	if (impl->use_worker)
+		flush_source(impl, impl->aec_blocksize);
 
 	pw_stream_queue_buffer(impl->capture, buf);
 }
@@ -575,10 +785,15 @@ static void source_state_changed(void *data, enum pw_stream_state old,
 	}
 }
 
-static void reset_buffers(struct impl *impl)
+static int do_reset_buffers(struct spa_loop *loop, bool async, uint32_t seq,
+		const void *data, size_t size, void *user_data)
 {
+	struct impl *impl = user_data;
 	uint32_t index, i;
 
+	/* runs in the data loop, the lock keeps the worker out */
+	pthread_mutex_lock(&impl->worker_lock);
+
 	spa_ringbuffer_init(&impl->rec_ring);
 	spa_ringbuffer_init(&impl->play_ring);
 	spa_ringbuffer_init(&impl->play_delayed_ring);
@@ -595,6 +810,17 @@ static void reset_buffers(struct impl *impl)
 	spa_ringbuffer_write_update(&impl->play_ring, index + (sizeof(float) * (impl->buffer_delay)));
 	spa_ringbuffer_get_read_index(&impl->play_ring, &index);
 	spa_ringbuffer_read_update(&impl->play_ring, index + (sizeof(float) * (impl->buffer_delay)));
+	/* the delay is available to the reader of the delayed ring */
+	spa_ringbuffer_get_write_index(&impl->play_delayed_ring, &index);
+	spa_ringbuffer_write_update(&impl->play_delayed_ring, index + (sizeof(float) * (impl->buffer_delay)));
+
+	pthread_mutex_unlock(&impl->worker_lock);
+	return 0;
+}
+
+static void reset_buffers(struct impl *impl)
+{
+	pw_data_loop_invoke(impl->data_loop, do_reset_buffers, 0, NULL, 0, true, impl);
 }
 
 static void input_param_latency_changed(struct impl *impl, const struct spa_pod *param)
@@ -844,9 +1070,22 @@ static void sink_process(void *data)
 
 	avail = spa_ringbuffer_get_write_index(&impl->play_ring, &index);
 
+	if (impl->use_worker) {
+		uint32_t dindex;
+		/* the worker reads the delayed data, it can be behind the playback */
+		avail = SPA_MAX(avail, spa_ringbuffer_get_write_index(&impl->play_delayed_ring, &dindex));
+	}
+
 	if (avail + size > impl->play_ringsize) {
 		uint32_t rindex, drop;
 
+		if (impl->use_worker) {
+			/* the worker owns the delayed read index, drop the new data */
+			pw_log_debug("sink ringbuffer xrun %d + %u > %u, dropping %u",
+					avail, size, impl->play_ringsize, size);
+			goto done;
+		}
+
 		/* Drop enough so we have size bytes left */
 		drop = avail + size - impl->play_ringsize;
 		pw_log_debug("sink ringbuffer xrun %d + %u > %u, dropping %u",
@@ -878,12 +1117,18 @@ static void sink_process(void *data)
 				SPA_PTROFF(d->data, offs, void), size);
 	}
 	spa_ringbuffer_write_update(&impl->play_ring, index + size);
+	spa_ringbuffer_write_update(&impl->play_delayed_ring, index + size);
 
-	if (avail + size >= impl->aec_blocksize) {
+	if (impl->use_worker) {
+		sem_post(&impl->worker_wakeup);
+	} else if (avail + size >= impl->aec_blocksize) {
 		impl->sink_ready = true;
 		if (impl->capture_ready)
 			process(impl);
 	}
+done:
+	if (impl->use_worker)
+		flush_playback(impl, impl->aec_blocksize);
 
 	pw_stream_queue_buffer(impl->sink, buf);
 }
@@ -1095,6 +1340,7 @@ static const struct pw_proxy_events core_proxy_events = {
 static void impl_destroy(struct impl *impl)
 {
 	uint32_t i;
+
 	if (impl->capture)
 		pw_stream_destroy(impl->capture);
 	if (impl->source)
@@ -1103,6 +1349,9 @@ static void impl_destroy(struct impl *impl)
 		pw_stream_destroy(impl->playback);
 	if (impl->sink)
 		pw_stream_destroy(impl->sink);
+
+	/* the streams wake up the worker, stop it only when they are gone */
+	stop_worker(impl);
 	if (impl->core && impl->do_disconnect)
 		pw_core_disconnect(impl->core);
 	if (impl->spa_handle)
@@ -1118,6 +1367,8 @@ static void impl_destroy(struct impl *impl)
 		free(impl->play_buffer[i]);
 	for (i = 0; i < impl->out_info.channels; i++)
 		free(impl->out_buffer[i]);
+	free(impl->worker_data);
+	pthread_mutex_destroy(&impl->worker_lock);
 
 	free(impl);
 }
@@ -1214,6 +1465,8 @@ int pipewire__module_init(struct pw_impl_module *module, const char *args)
 	if (impl == NULL)
 		return -errno;
 
+	pthread_mutex_init(&impl->worker_lock, NULL);
+
 	pw_log_debug("module %p: new %s", impl, args);
 
 	if (args)
@@ -1243,6 +1496,7 @@ int pipewire__module_init(struct pw_impl_module *module, const char *args)
 
 	impl->module = module;
 	impl->context = context;
+	impl->data_loop = pw_context_get_data_loop(context);
 
 	if (pw_properties_get(props, PW_KEY_NODE_GROUP) == NULL)
 		pw_properties_setf(props, PW_KEY_NODE_GROUP, "echo-cancel-%u-%u", pid, id);
@@ -1469,6 +1723,14 @@ int pipewire__module_init(struct pw_impl_module *module, const char *args)
 
 	copy_props(impl, props, PW_KEY_NODE_LATENCY);
 
+	if ((str = pw_properties_get(props, "aec.worker")) != NULL)
+		impl->use_worker = pw_properties_parse_bool(str);
+	if (impl->use_worker) {
+		pw_log_info("running %s in a worker thread", impl->aec->name);
+		if ((res = start_worker(impl)) < 0)
+			goto error;
+	}
+
 	impl->core = pw_context_get_object(impl->context, PW_TYPE_INTERFACE_Core);
 	if (impl->core == NULL) {
 		str = pw_properties_get(props, PW_KEY_REMOTE_NAME);
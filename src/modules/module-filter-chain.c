@@ -18,6 +18,7 @@
 #include <spa/utils/result.h>
 #include <spa/utils/string.h>
 #include <spa/utils/json.h>
+#include <spa/utils/atomic.h>
 #include <spa/support/cpu.h>
 #include <spa/param/latency-utils.h>
 #include <spa/pod/dynamic.h>
@@ -51,6 +52,9 @@ PW_LOG_TOPIC_STATIC(mod_topic, "mod." NAME);
  *
  * - `node.description`: a human readable name for the filter chain
  * - `filter.graph = []`: a description of the filter graph to run, see below
+ * - `filter.graph.threads = 1`: the number of threads to run the graph with. The
+ *    copies of the graph for each channel are divided over the threads. Only
+ *    these copies run in parallel, the nodes inside one copy run in order.
  * - `capture.props = {}`: properties to be passed to the input stream
  * - `playback.props = {}`: properties to be passed to the output stream
  *
@@ -495,6 +499,7 @@ static const struct spa_dict_item module_props[] = {
 				"    inputs = [ <portname> ... ] "
 				"    outputs = [ <portname> ... ] "
 				"] "
+				"( filter.graph.threads=<number of threads> ) "
 				"( capture.props=<properties> ) "
 				"( playback.props=<properties> ) " },
 	{ PW_KEY_MODULE_VERSION, PACKAGE_VERSION },
@@ -507,6 +512,7 @@ static const struct spa_dict_item module_props[] = {
 #include <getopt.h>
 #include <limits.h>
 #include <math.h>
+#include <semaphore.h>
 
 #include <spa/utils/result.h>
 #include <spa/pod/builder.h>
@@ -514,6 +520,7 @@ static const struct spa_dict_item module_props[] = {
 #include <spa/param/audio/raw.h>
 
 #include <pipewire/pipewire.h>
+#include <pipewire/thread.h>
 
 #define MAX_HNDL 64
 #define MAX_SAMPLES 8192
@@ -576,6 +583,8 @@ struct port {
 	uint32_t external;
 
 	float control_data;
+	float control_pending;
+	float control_next;
 	float *audio_data[MAX_HNDL];
 };
 
@@ -596,10 +605,14 @@ struct node {
 	uint32_t n_hndl;
 	void *hndl[MAX_HNDL];
 
+	uint32_t control_seq;
+
 	unsigned int n_deps;
 	unsigned int visited:1;
 	unsigned int disabled:1;
 	unsigned int control_changed:1;
+	unsigned int elided:1;
+	unsigned int fused:1;
 };
 
 struct link {
@@ -622,6 +635,27 @@ struct graph_port {
 struct graph_hndl {
 	const struct fc_descriptor *desc;
 	void **hndl;
+	uint32_t n_hndl;
+	struct node *node;
+	uint32_t n_sections;
+	struct node **section;
+	void **instances;
+};
+
+struct graph_worker {
+	struct graph *graph;
+	struct spa_thread *thread;
+	sem_t start;
+
+	uint32_t first_channel;
+	uint32_t n_channels;
+	uint32_t n_hndl;
+	struct graph_hndl *hndl;
+	void **instances;
+
+	/* scratch for the unused outputs of the channels of this worker */
+	float *discard_data;
+	float notify_data;
 };
 
 struct graph {
@@ -638,10 +672,24 @@ struct graph {
 
 	uint32_t n_hndl;
 	struct graph_hndl *hndl;
+	struct node **section;
+	void **instances;
 
 	uint32_t n_control;
 	struct port **control_port;
 
+	/* odd while the main thread updates control_pending */
+	uint32_t control_seq;
+	uint32_t control_applied;
+	bool streaming;
+
+	uint32_t n_threads;
+	uint32_t n_workers;
+	struct graph_worker *workers;
+	sem_t done;
+	unsigned long n_samples;
+	bool running;
+
 	unsigned instantiated:1;
 };
 
@@ -684,7 +732,103 @@ struct impl {
 
 static int graph_instantiate(struct graph *graph);
 static void graph_cleanup(struct graph *graph);
+static void graph_stop_workers(struct graph *graph);
+
+static inline void graph_hndl_run(struct graph_hndl *hndl, unsigned long n_samples)
+{
+	if (hndl->n_sections > 1)
+		hndl->desc->run_multi(hndl->instances, hndl->n_hndl,
+				hndl->n_sections, n_samples);
+	else if (hndl->n_hndl > 1)
+		hndl->desc->run_multi(hndl->hndl, hndl->n_hndl, 1, n_samples);
+	else
+		hndl->desc->run(*hndl->hndl, n_samples);
+}
+
+static void *graph_worker_thread(void *data)
+{
+	struct graph_worker *w = data;
+	struct graph *graph = w->graph;
+	uint32_t i;
+
+	while (true) {
+		sem_wait(&w->start);
+		if (!SPA_ATOMIC_LOAD(graph->running))
+			break;
+		for (i = 0; i < w->n_hndl; i++)
+			graph_hndl_run(&w->hndl[i], graph->n_samples);
+		sem_post(&graph->done);
+	}
+	return NULL;
+}
+
+/* the first worker runs in the data thread, wake up the others and wait
+ * until all of them are done with the cycle */
+static void graph_run_workers(struct graph *graph, unsigned long n_samples)
+{
+	struct graph_worker *w = &graph->workers[0];
+	uint32_t i;
+
+	graph->n_samples = n_samples;
+	for (i = 1; i < graph->n_workers; i++)
+		sem_post(&graph->workers[i].start);
+
+	for (i = 0; i < w->n_hndl; i++)
+		graph_hndl_run(&w->hndl[i], n_samples);
+
+	for (i = 1; i < graph->n_workers; i++) {
+		while (sem_wait(&graph->done) < 0 && errno == EINTR);
+	}
+}
+
 
+static int do_control_changed(struct spa_loop *loop, bool async, uint32_t seq,
+		const void *data, size_t size, void *user_data);
+
+/* The plugins read the controls from control_data. The main thread writes
+ * new values to control_pending, they are copied to control_data by the
+ * data thread at the start of a cycle, only when the main thread is not
+ * in the middle of an update, so that a cycle never sees half of a set
+ * of changes. */
+static void graph_apply_controls(struct graph *graph)
+{
+	struct impl *impl = graph->impl;
+	struct node *node;
+	uint32_t i, seq1, seq2;
+	bool notify = false;
+
+	seq1 = SPA_SEQ_READ(graph->control_seq);
+	if (seq1 == graph->control_applied || (seq1 & 1))
+		return;
+
+	spa_list_for_each(node, &graph->node_list, link) {
+		for (i = 0; i < node->desc->n_control; i++) {
+			struct port *port = &node->control_port[i];
+			port->control_next = port->control_pending;
+		}
+	}
+	seq2 = SPA_SEQ_READ(graph->control_seq);
+	if (!SPA_SEQ_READ_SUCCESS(seq1, seq2))
+		return;
+
+	spa_list_for_each(node, &graph->node_list, link) {
+		bool changed = false;
+		for (i = 0; i < node->desc->n_control; i++) {
+			struct port *port = &node->control_port[i];
+			if (port->control_data != port->control_next) {
+				port->control_data = port->control_next;
+				changed = true;
+			}
+		}
+		if (changed && node->desc->desc->control_changed)
+			notify = true;
+	}
+	graph->control_applied = seq1;
+
+	if (notify)
+		pw_loop_invoke(pw_context_get_main_loop(impl->context),
+				do_control_changed, seq1, NULL, 0, false, impl);
+}
 
 static void capture_destroy(void *d)
 {
@@ -727,6 +871,8 @@ static void playback_process(void *d)
 	if (in == NULL || out == NULL)
 		goto done;
 
+	graph_apply_controls(graph);
+
 	for (i = 0, j = 0; i < in->buffer->n_datas; i++) {
 		uint32_t offs, size;
 
@@ -769,9 +915,11 @@ static void playback_process(void *d)
 	pw_log_trace_fp("%p: stride:%d in:%d out:%d requested:%"PRIu64" (%"PRIu64")", impl,
 			stride, insize, outsize, out->requested, out->requested * stride);
 
-	for (i = 0; i < n_hndl; i++) {
-		struct graph_hndl *hndl = &graph->hndl[i];
-		hndl->desc->run(*hndl->hndl, outsize / sizeof(float));
+	if (graph->n_workers > 0) {
+		graph_run_workers(graph, outsize / sizeof(float));
+	} else {
+		for (i = 0; i < n_hndl; i++)
+			graph_hndl_run(&graph->hndl[i], outsize / sizeof(float));
 	}
 
 done:
@@ -961,11 +1109,11 @@ static struct spa_pod *get_props_param(struct graph *graph, struct spa_pod_build
 
 		spa_pod_builder_string(b, name);
 		if (p->hint & FC_HINT_BOOLEAN) {
-			spa_pod_builder_bool(b, port->control_data <= 0.0f ? false : true);
+			spa_pod_builder_bool(b, port->control_pending <= 0.0f ? false : true);
 		} else if (p->hint & FC_HINT_INTEGER) {
-			spa_pod_builder_int(b, port->control_data);
+			spa_pod_builder_int(b, port->control_pending);
 		} else {
-			spa_pod_builder_float(b, port->control_data);
+			spa_pod_builder_float(b, port->control_pending);
 		}
 	}
 	spa_pod_builder_pop(b, &f[1]);
@@ -985,11 +1133,15 @@ static int set_control_value(struct node *node, const char *name, float *value)
 	node = port->node;
 	desc = node->desc;
 
-	old = port->control_data;
-	port->control_data = value ? *value : desc->default_control[port->idx];
-	pw_log_info("control %d ('%s') from %f to %f", port->idx, name, old, port->control_data);
-	node->control_changed = old != port->control_data;
-	return node->control_changed ? 1 : 0;
+	old = port->control_pending;
+	port->control_pending = value ? *value : desc->default_control[port->idx];
+	pw_log_info("control %d ('%s') from %f to %f", port->idx, name, old, port->control_pending);
+	if (old != port->control_pending)
+		node->control_changed = true;
+	/* without a data thread there is nobody to apply the new value */
+	if (!node->graph->streaming)
+		port->control_data = port->control_pending;
+	return old != port->control_pending ? 1 : 0;
 }
 
 static int parse_params(struct graph *graph, const struct spa_pod *pod)
@@ -1037,16 +1189,20 @@ static int parse_params(struct graph *graph, const struct spa_pod *pod)
 
 static void graph_reset(struct graph *graph)
 {
+	struct node *node;
 	uint32_t i;
-	for (i = 0; i < graph->n_hndl; i++) {
-		struct graph_hndl *hndl = &graph->hndl[i];
-		const struct fc_descriptor *d = hndl->desc;
-		if (hndl->hndl == NULL || *hndl->hndl == NULL)
+	spa_list_for_each(node, &graph->node_list, link) {
+		const struct fc_descriptor *d = node->desc->desc;
+		if (node->disabled)
 			continue;
-		if (d->deactivate)
-			d->deactivate(*hndl->hndl);
-		if (d->activate)
-			d->activate(*hndl->hndl);
+		for (i = 0; i < node->n_hndl; i++) {
+			if (node->hndl[i] == NULL)
+				continue;
+			if (d->deactivate)
+				d->deactivate(node->hndl[i]);
+			if (d->activate)
+				d->activate(node->hndl[i]);
+		}
 	}
 }
 
@@ -1067,6 +1223,38 @@ static void node_control_changed(struct node *node)
 	node->control_changed = false;
 }
 
+/* called in the main thread when the data thread applied the controls
+ * up to seq */
+static int do_control_changed(struct spa_loop *loop, bool async, uint32_t seq,
+		const void *data, size_t size, void *user_data)
+{
+	struct impl *impl = user_data;
+	struct node *node;
+
+	spa_list_for_each(node, &impl->graph.node_list, link) {
+		if ((int32_t)(node->control_seq - seq) <= 0)
+			node_control_changed(node);
+	}
+	return 0;
+}
+
+/* apply the pending controls from the main thread, when there is no
+ * data thread processing the graph */
+static void graph_sync_controls(struct graph *graph)
+{
+	struct node *node;
+	uint32_t i;
+
+	spa_list_for_each(node, &graph->node_list, link) {
+		for (i = 0; i < node->desc->n_control; i++) {
+			struct port *port = &node->control_port[i];
+			port->control_data = port->control_pending;
+		}
+		node_control_changed(node);
+	}
+	graph->control_applied = SPA_SEQ_READ(graph->control_seq);
+}
+
 static void update_props_param(struct impl *impl)
 {
 	struct graph *graph = &impl->graph;
@@ -1087,17 +1275,25 @@ static void param_props_changed(struct impl *impl, const struct spa_pod *param)
 	const struct spa_pod_prop *prop;
 	struct graph *graph = &impl->graph;
 	int changed = 0;
+	uint32_t seq;
 
+	SPA_SEQ_WRITE(graph->control_seq);
 	SPA_POD_OBJECT_FOREACH(obj, prop) {
 		if (prop->key == SPA_PROP_params)
 			changed += parse_params(graph, &prop->value);
 	}
+	seq = SPA_SEQ_WRITE(graph->control_seq);
+
 	if (changed > 0) {
 		struct node *node;
 
-		spa_list_for_each(node, &graph->node_list, link)
-			node_control_changed(node);
-
+		/* the data thread calls back when it applied the controls */
+		spa_list_for_each(node, &graph->node_list, link) {
+			if (node->control_changed)
+				node->control_seq = seq;
+			if (!graph->streaming)
+				node_control_changed(node);
+		}
 		update_props_param(impl);
 	}
 }
@@ -1128,6 +1324,11 @@ static void state_changed(void *data, enum pw_stream_state old,
 	struct graph *graph = &impl->graph;
 	int res;
 
+	if (state != PW_STREAM_STATE_STREAMING && graph->streaming) {
+		graph->streaming = false;
+		graph_sync_controls(graph);
+	}
+
 	switch (state) {
 	case PW_STREAM_STATE_PAUSED:
 		pw_stream_flush(impl->playback, false);
@@ -1157,6 +1358,7 @@ static void state_changed(void *data, enum pw_stream_state old,
 			if ((res = graph_instantiate(graph)) < 0)
 				goto error;
 		}
+		graph->streaming = true;
 		break;
 	}
 	default:
@@ -1877,7 +2079,7 @@ static int load_node(struct graph *graph, struct spa_json *json)
 		port->external = SPA_ID_INVALID;
 		port->p = desc->control[i];
 		spa_list_init(&port->link_list);
-		port->control_data = desc->default_control[i];
+		port->control_data = port->control_pending = desc->default_control[i];
 	}
 	for (i = 0; i < desc->n_notify; i++) {
 		struct port *port = &node->notify_port[i];
@@ -1914,6 +2116,17 @@ static void node_cleanup(struct node *node)
 	}
 }
 
+/* the output of an elided copy node is the output that feeds its input */
+static struct port *port_source(struct port *port)
+{
+	while (port->node->elided) {
+		struct link *link = spa_list_first(&port->node->input_port[0].link_list,
+				struct link, input_link);
+		port = link->output;
+	}
+	return port;
+}
+
 static int port_ensure_data(struct port *port, uint32_t i)
 {
 	float *data;
@@ -1963,6 +2176,43 @@ static void graph_cleanup(struct graph *graph)
 		node_cleanup(node);
 }
 
+/* the output goes into the next section of a cascade and is not used */
+static bool port_is_fused(struct port *port)
+{
+	struct link *link;
+
+	if (port->n_links != 1)
+		return false;
+	link = spa_list_first(&port->link_list, struct link, output_link);
+	return link->input->node->fused;
+}
+
+/* the worker that runs the copy of the graph for channel i */
+static struct graph_worker *graph_channel_worker(struct graph *graph, uint32_t i)
+{
+	uint32_t j;
+
+	for (j = 0; j < graph->n_workers; j++) {
+		struct graph_worker *w = &graph->workers[j];
+		if (i >= w->first_channel && i < w->first_channel + w->n_channels)
+			return w;
+	}
+	return NULL;
+}
+
+/* collect the instances of a cascade after they have been created */
+static void graph_hndl_link(struct graph_hndl *gh)
+{
+	uint32_t i, first;
+
+	if (gh->n_sections <= 1)
+		return;
+
+	first = gh->hndl - &gh->section[0]->hndl[0];
+	for (i = 0; i < gh->n_sections * gh->n_hndl; i++)
+		gh->instances[i] = gh->section[i / gh->n_hndl]->hndl[first + i % gh->n_hndl];
+}
+
 static int graph_instantiate(struct graph *graph)
 {
 	struct impl *impl = graph->impl;
@@ -1984,12 +2234,27 @@ static int graph_instantiate(struct graph *graph)
 
 		node_cleanup(node);
 
+		/* the peers of an elided node read from its source */
+		if (node->elided)
+			continue;
+
 		desc = node->desc;
 		d = desc->desc;
 		if (d->flags & FC_DESCRIPTOR_SUPPORTS_NULL_DATA)
 			sd = dd = NULL;
 
 		for (i = 0; i < node->n_hndl; i++) {
+			struct graph_worker *w = graph_channel_worker(graph, i);
+			float *cd = dd, *nd = NULL;
+
+			/* the workers run at the same time, they can't share the
+			 * buffers that are written but not used */
+			if (w != NULL && w->discard_data != NULL) {
+				if (cd != NULL)
+					cd = w->discard_data;
+				nd = &w->notify_data;
+			}
+
 			pw_log_info("instantiate %s %d rate:%lu", d->name, i, impl->rate);
 			errno = EINVAL;
 			if ((node->hndl[i] = d->instantiate(d, impl->rate, i, node->config)) == NULL) {
@@ -2000,9 +2265,11 @@ static int graph_instantiate(struct graph *graph)
 			for (j = 0; j < desc->n_input; j++) {
 				port = &node->input_port[j];
 				d->connect_port(node->hndl[i], port->p, sd);
+				if (node->fused)
+					continue;
 
 				spa_list_for_each(link, &port->link_list, input_link) {
-					struct port *peer = link->output;
+					struct port *peer = port_source(link->output);
 					if ((res = port_ensure_data(peer, i)) < 0)
 						goto error;
 					pw_log_info("connect input port %s[%d]:%s %p",
@@ -2013,6 +2280,10 @@ static int graph_instantiate(struct graph *graph)
 			}
 			for (j = 0; j < desc->n_output; j++) {
 				port = &node->output_port[j];
+				if (port_is_fused(port)) {
+					d->connect_port(node->hndl[i], port->p, cd);
+					continue;
+				}
 				if ((res = port_ensure_data(port, i)) < 0)
 					goto error;
 				pw_log_info("connect output port %s[%d]:%s %p",
@@ -2036,8 +2307,9 @@ static int graph_instantiate(struct graph *graph)
 				port = &node->notify_port[j];
 				pw_log_info("connect notify port %s[%d]:%s %p",
 						node->name, i, d->ports[port->p].name,
-						&port->control_data);
-				d->connect_port(node->hndl[i], port->p, &port->control_data);
+						nd ? nd : &port->control_data);
+				d->connect_port(node->hndl[i], port->p,
+						nd ? nd : &port->control_data);
 			}
 			if (d->activate)
 				d->activate(node->hndl[i]);
@@ -2045,6 +2317,13 @@ static int graph_instantiate(struct graph *graph)
 				d->control_changed(node->hndl[i]);
 		}
 	}
+	for (i = 0; i < graph->n_hndl; i++)
+		graph_hndl_link(&graph->hndl[i]);
+	for (i = 0; i < graph->n_workers; i++) {
+		struct graph_worker *w = &graph->workers[i];
+		for (j = 0; j < w->n_hndl; j++)
+			graph_hndl_link(&w->hndl[j]);
+	}
 	update_props_param(impl);
 	return 0;
 error:
@@ -2064,6 +2343,144 @@ static struct node *find_next_node(struct graph *graph)
 	return NULL;
 }
 
+static bool port_is_external(struct graph *graph, struct port *port)
+{
+	struct node *node = port->node;
+	uint32_t i;
+
+	if (port->external != SPA_ID_INVALID)
+		return true;
+	for (i = 0; i < graph->n_input; i++) {
+		struct graph_port *gp = &graph->input[i];
+		if (gp->desc != NULL && gp->port == port->p &&
+		    gp->hndl >= &node->hndl[0] && gp->hndl < &node->hndl[node->n_hndl])
+			return true;
+	}
+	for (i = 0; i < graph->n_output; i++) {
+		struct graph_port *gp = &graph->output[i];
+		if (gp->desc != NULL && gp->port == port->p &&
+		    gp->hndl >= &node->hndl[0] && gp->hndl < &node->hndl[node->n_hndl])
+			return true;
+	}
+	return false;
+}
+
+/* a copy node with one source that is not used as a graph port can be removed,
+ * its peers read from the source directly */
+static bool node_can_elide(struct graph *graph, struct node *node)
+{
+	struct descriptor *desc = node->desc;
+
+	if (node->disabled || !(desc->desc->flags & FC_DESCRIPTOR_COPY) ||
+	    desc->n_input != 1 || desc->n_output != 1)
+		return false;
+	if (node->input_port[0].n_links != 1 ||
+	    port_is_external(graph, &node->input_port[0]) ||
+	    port_is_external(graph, &node->output_port[0]))
+		return false;
+	return true;
+}
+
+/* the next node of a cascade, when the only output of the node goes to
+ * the only input of a node with the same run_multi function */
+static struct node *node_cascade_next(struct graph *graph, struct node *node)
+{
+	struct descriptor *desc = node->desc;
+	struct port *out, *in;
+	struct link *link;
+	struct node *next;
+	uint32_t i;
+
+	if (desc->desc->run_multi == NULL || desc->n_input != 1 || desc->n_output != 1)
+		return NULL;
+
+	out = &node->output_port[0];
+	if (out->n_links != 1 || port_is_external(graph, out))
+		return NULL;
+
+	link = spa_list_first(&out->link_list, struct link, output_link);
+	in = link->input;
+	next = in->node;
+	if (next->disabled || next->desc->desc->run_multi != desc->desc->run_multi ||
+	    next->desc->n_input != 1 || next->desc->n_output != 1 ||
+	    in->n_links != 1 || port_is_external(graph, in))
+		return NULL;
+
+	/* controls from other nodes need to be updated before the node runs */
+	for (i = 0; i < next->desc->n_control; i++) {
+		if (next->control_port[i].n_links > 0)
+			return NULL;
+	}
+	return next;
+}
+
+/* remove copy nodes and merge cascades of nodes into one run_multi call,
+ * the buffers between the nodes are then not used anymore */
+static int graph_compile(struct graph *graph, uint32_t n_nodes, uint32_t n_hndl)
+{
+	struct node *node, *next;
+	uint32_t i, j, n, n_section = 0, n_instance = 0;
+
+	spa_list_for_each(node, &graph->node_list, link) {
+		if (node_can_elide(graph, node)) {
+			pw_log_info("elide copy node %s", node->name);
+			node->elided = true;
+			node->disabled = true;
+		}
+	}
+
+	graph->section = calloc(n_nodes, sizeof(struct node *));
+	graph->instances = calloc(n_nodes * n_hndl, sizeof(void *));
+	if (graph->section == NULL || graph->instances == NULL)
+		return -errno;
+
+	for (i = 0, n = 0; i < graph->n_hndl; i++) {
+		struct graph_hndl *gh = &graph->hndl[i];
+
+		node = gh->node;
+		if (node->fused || node->elided)
+			continue;
+
+		graph->hndl[n] = *gh;
+		gh = &graph->hndl[n++];
+
+		if (gh->n_hndl != n_hndl && n_hndl > 1)
+			continue;
+
+		gh->section = &graph->section[n_section];
+		gh->section[0] = node;
+		while ((next = node_cascade_next(graph, node)) != NULL) {
+			next->fused = true;
+			gh->section[gh->n_sections++] = node = next;
+		}
+		if (gh->n_sections == 1) {
+			gh->section = NULL;
+			continue;
+		}
+
+		gh->n_hndl = n_hndl;
+		gh->hndl = &gh->section[0]->hndl[0];
+		gh->instances = &graph->instances[n_instance];
+		n_section += gh->n_sections;
+		n_instance += gh->n_sections * n_hndl;
+	}
+	graph->n_hndl = n;
+
+	for (i = 0; i < graph->n_hndl; i++) {
+		struct graph_hndl *gh = &graph->hndl[i];
+		char sections[1024] = "";
+		size_t len = 0;
+
+		for (j = 1; j < gh->n_sections && len < sizeof(sections); j++)
+			len += snprintf(sections + len, sizeof(sections) - len,
+					" -> %s", gh->section[j]->name);
+
+		pw_log_info("plan %d: %s:%s x%d%s", i, gh->node->name,
+				gh->desc->name, gh->n_hndl, sections);
+	}
+	return 0;
+}
+
 static int setup_graph(struct graph *graph, struct spa_json *inputs, struct spa_json *outputs)
 {
 	struct impl *impl = graph->impl;
@@ -2298,10 +2715,23 @@ static int setup_graph(struct graph *graph, struct spa_json *inputs, struct spa_
 		d = desc->desc;
 
 		if (!node->disabled) {
-			for (i = 0; i < n_hndl; i++) {
+			if (d->run_multi != NULL && n_hndl > 1) {
+				/* all copies of the node run in one call */
 				gh = &graph->hndl[graph->n_hndl++];
-				gh->hndl = &node->hndl[i];
+				gh->hndl = &node->hndl[0];
+				gh->n_hndl = n_hndl;
+				gh->node = node;
+				gh->n_sections = 1;
 				gh->desc = d;
+			} else {
+				for (i = 0; i < n_hndl; i++) {
+					gh = &graph->hndl[graph->n_hndl++];
+					gh->hndl = &node->hndl[i];
+					gh->n_hndl = 1;
+					gh->node = node;
+					gh->n_sections = 1;
+					gh->desc = d;
+				}
 			}
 		}
 		for (i = 0; i < desc->n_output; i++) {
@@ -2315,11 +2745,118 @@ static int setup_graph(struct graph *graph, struct spa_json *inputs, struct spa_
 			graph->n_control++;
 		}
 	}
-	res = 0;
+	res = graph_compile(graph, n_nodes, n_hndl);
 error:
 	return res;
 }
 
+/* divide the copies of the graph for each channel over the workers, the
+ * copies don't share any data so they can run in parallel. The nodes of
+ * one copy always run in order in the same worker, independent branches
+ * inside the graph are not run in parallel. */
+static int graph_start_workers(struct graph *graph)
+{
+	struct node *first, *node;
+	uint32_t i, j, n_chan, n_workers;
+	int res;
+
+	if (spa_list_is_empty(&graph->node_list))
+		return 0;
+
+	first = spa_list_first(&graph->node_list, struct node, link);
+	n_chan = first->n_hndl;
+	n_workers = SPA_MIN(graph->n_threads, n_chan);
+	if (n_workers <= 1)
+		return 0;
+
+	/* a notify port linked to a control passes values between the channels */
+	spa_list_for_each(node, &graph->node_list, link) {
+		for (i = 0; i < node->desc->n_notify; i++) {
+			if (node->notify_port[i].n_links > 0) {
+				pw_log_info("notify port of %s is linked, not using threads",
+						node->name);
+				return 0;
+			}
+		}
+	}
+
+	graph->workers = calloc(n_workers, sizeof(struct graph_worker));
+	if (graph->workers == NULL)
+		return -errno;
+
+	sem_init(&graph->done, 0, 0);
+	graph->n_workers = n_workers;
+	SPA_ATOMIC_STORE(graph->running, true);
+
+	for (i = 0; i < n_workers; i++) {
+		struct graph_worker *w = &graph->workers[i];
+		uint32_t c0 = i * n_chan / n_workers;
+		uint32_t c1 = (i + 1) * n_chan / n_workers;
+		uint32_t n_instance = 0, n_instances = 0;
+
+		w->graph = graph;
+		w->first_channel = c0;
+		w->n_channels = c1 - c0;
+		sem_init(&w->start, 0, 0);
+
+		/* a cascade needs the instances of all its sections */
+		for (j = 0; j < graph->n_hndl; j++) {
+			struct graph_hndl *gh = &graph->hndl[j];
+			if (gh->n_hndl > 1 && gh->n_sections > 1)
+				n_instances += gh->n_sections * (c1 - c0);
+		}
+
+		w->hndl = calloc(graph->n_hndl, sizeof(struct graph_hndl));
+		w->instances = calloc(SPA_MAX(n_instances, 1u), sizeof(void *));
+		if (w->hndl == NULL || w->instances == NULL) {
+			res = -errno;
+			goto error;
+		}
+
+		for (j = 0; j < graph->n_hndl; j++) {
+			struct graph_hndl *gh = &graph->hndl[j], *wh;
+
+			if (gh->n_hndl == 1) {
+				uint32_t c = gh->hndl - &gh->node->hndl[0];
+				if (c < c0 || c >= c1)
+					continue;
+				w->hndl[w->n_hndl++] = *gh;
+				continue;
+			}
+			wh = &w->hndl[w->n_hndl++];
+			*wh = *gh;
+			wh->hndl = gh->hndl + c0;
+			wh->n_hndl = c1 - c0;
+			if (wh->n_sections > 1) {
+				wh->instances = &w->instances[n_instance];
+				n_instance += wh->n_sections * wh->n_hndl;
+			}
+		}
+		pw_log_info("worker %d: channels %d-%d, %d handles", i, c0, c1 - 1, w->n_hndl);
+
+		/* the first worker runs in the data thread */
+		if (i == 0)
+			continue;
+
+		w->discard_data = calloc(MAX_SAMPLES, sizeof(float));
+		if (w->discard_data == NULL) {
+			res = -errno;
+			goto error;
+		}
+		w->thread = pw_thread_utils_create(NULL, graph_worker_thread, w);
+		if (w->thread == NULL) {
+			res = -errno;
+			pw_log_error("can't create worker thread: %m");
+			goto error;
+		}
+		pw_thread_utils_acquire_rt(w->thread, -1);
+	}
+	return 0;
+error:
+	graph_stop_workers(graph);
+	return res;
+}
+
 /**
  * filter.graph = {
  *     nodes = [
@@ -2400,13 +2937,47 @@ static int load_graph(struct graph *graph, struct pw_properties *props)
 				return res;
 		}
 	}
-	return setup_graph(graph, pinputs, poutputs);
+	graph->n_threads = pw_properties_get_uint32(props, "filter.graph.threads", 1);
+
+	if ((res = setup_graph(graph, pinputs, poutputs)) < 0)
+		return res;
+
+	return graph_start_workers(graph);
+}
+
+static void graph_stop_workers(struct graph *graph)
+{
+	uint32_t i;
+
+	if (graph->workers == NULL)
+		return;
+
+	SPA_ATOMIC_STORE(graph->running, false);
+	for (i = 1; i < graph->n_workers; i++) {
+		struct graph_worker *w = &graph->workers[i];
+		if (w->thread == NULL)
+			continue;
+		sem_post(&w->start);
+		pw_thread_utils_join(w->thread, NULL);
+	}
+	for (i = 0; i < graph->n_workers; i++) {
+		struct graph_worker *w = &graph->workers[i];
+		sem_destroy(&w->start);
+		free(w->hndl);
+		free(w->instances);
+		free(w->discard_data);
+	}
+	sem_destroy(&graph->done);
+	free(graph->workers);
+	graph->workers = NULL;
+	graph->n_workers = 0;
 }
 
 static void graph_free(struct graph *graph)
 {
 	struct link *link;
 	struct node *node;
+	graph_stop_workers(graph);
 	spa_list_consume(link, &graph->link_list, link)
 		link_free(link);
 	spa_list_consume(node, &graph->node_list, link)
@@ -2414,6 +2985,8 @@ static void graph_free(struct graph *graph)
 	free(graph->input);
 	free(graph->output);
 	free(graph->hndl);
+	free(graph->section);
+	free(graph->instances);
 	free(graph->control_port);
 }
 
@@ -0,0 +1,279 @@
+/* PipeWire */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include "config.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include <spa/support/cpu.h>
+#include <spa/utils/defs.h>
+
+#include "spa/plugins/audiomixer/test-helper.h"
+
+#include "biquad.h"
+#include "dsp-ops.h"
+
+static uint32_t cpu_flags;
+
+typedef void (*biquadn_func_t) (struct dsp_ops *ops, struct biquad *bq[], uint32_t n_bq,
+		uint32_t n_sections, float *out[], const float *in[], uint32_t n_samples);
+
+struct stats {
+	uint32_t n_samples;
+	uint32_t n_bq;
+	uint32_t n_sections;
+	uint64_t perf;
+	const char *name;
+	const char *impl;
+};
+
+#define MAX_SAMPLES	4096
+#define MAX_BQ		16
+#define MAX_SECTIONS	20
+
+#define MAX_COUNT 100
+
+static float samp_in[MAX_SAMPLES * MAX_BQ];
+static float samp_out[MAX_SAMPLES * MAX_BQ * MAX_SECTIONS];
+static struct biquad bqs[MAX_BQ * MAX_SECTIONS];
+
+static const int sample_sizes[] = { 0, 1, 128, 513, 1024, 4096 };
+static const int bq_counts[] = { 1, 2, 4, 6, 8, 16 };
+static const int section_counts[] = { 1, 2, 5, 10, 20 };
+
+#define MAX_RESULTS	SPA_N_ELEMENTS(sample_sizes) * SPA_N_ELEMENTS(bq_counts) * 4 + \
+			SPA_N_ELEMENTS(section_counts) * 8
+
+static uint32_t n_results = 0;
+static struct stats results[MAX_RESULTS];
+
+static void run_test1(const char *name, const char *impl, biquadn_func_t func,
+		int n_bq, int n_samples)
+{
+	int i, j;
+	struct biquad *bq[n_bq];
+	const float *ip[n_bq];
+	float *op[n_bq];
+	struct timespec ts;
+	uint64_t count, t1, t2;
+	struct dsp_ops ops;
+
+	spa_zero(ops);
+	ops.cpu_flags = cpu_flags;
+
+	for (j = 0; j < n_bq; j++) {
+		/* a 10 band room EQ uses peaking filters like this one */
+		biquad_set(&bqs[j], BQ_PEAKING, 0.02 + j * 0.01, 0.7, 3.0);
+		bq[j] = &bqs[j];
+		ip[j] = &samp_in[j * MAX_SAMPLES];
+		op[j] = &samp_out[j * MAX_SAMPLES];
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t1 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+	count = 0;
+	for (i = 0; i < MAX_COUNT; i++) {
+		func(&ops, bq, n_bq, 1, op, ip, n_samples);
+		count++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t2 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+	spa_assert(n_results < MAX_RESULTS);
+
+	results[n_results++] = (struct stats) {
+		.n_samples = n_samples,
+		.n_bq = n_bq,
+		.n_sections = 1,
+		.perf = count * (uint64_t)SPA_NSEC_PER_SEC / SPA_MAX(t2 - t1, 1u),
+		.name = name,
+		.impl = impl
+	};
+}
+
+static void run_test(const char *name, const char *impl, biquadn_func_t func)
+{
+	size_t i, j;
+
+	for (i = 0; i < SPA_N_ELEMENTS(sample_sizes); i++) {
+		for (j = 0; j < SPA_N_ELEMENTS(bq_counts); j++)
+			run_test1(name, impl, func, bq_counts[j], sample_sizes[i]);
+	}
+}
+
+/* checks the result of the SIMD version against the C version */
+static void check_biquadn(const char *impl, biquadn_func_t func, uint32_t n_sections)
+{
+	static struct biquad ref[MAX_BQ * MAX_SECTIONS];
+	static float out_ref[MAX_SAMPLES * MAX_BQ];
+	struct biquad *pref[MAX_BQ * MAX_SECTIONS], *pbq[MAX_BQ * MAX_SECTIONS];
+	const float *ip[MAX_BQ];
+	float *op[MAX_BQ], *oref[MAX_BQ];
+	struct dsp_ops ops;
+	uint32_t i, j, n_samples = 1021;
+
+	spa_zero(ops);
+	ops.cpu_flags = cpu_flags;
+
+	for (i = 0; i < MAX_BQ * n_sections; i++) {
+		biquad_set(&bqs[i], BQ_PEAKING, 0.02 + (i % 37) * 0.01, 0.7, 3.0);
+		ref[i] = bqs[i];
+		pbq[i] = &bqs[i];
+		pref[i] = &ref[i];
+	}
+	for (i = 0; i < MAX_BQ; i++) {
+		ip[i] = &samp_in[i * MAX_SAMPLES];
+		op[i] = &samp_out[i * MAX_SAMPLES];
+		oref[i] = &out_ref[i * MAX_SAMPLES];
+	}
+	for (j = 0; j < 2; j++) {
+		dsp_biquadn_run_c(&ops, pref, MAX_BQ, n_sections, oref, ip, n_samples);
+		func(&ops, pbq, MAX_BQ, n_sections, op, ip, n_samples);
+	}
+	for (i = 0; i < MAX_BQ; i++) {
+		for (j = 0; j < n_samples; j++) {
+			float diff = op[i][j] - oref[i][j];
+			if (diff < -1e-4f || diff > 1e-4f) {
+				fprintf(stderr, "%s: biquad %d sample %d: %f != %f\n",
+						impl, i, j, op[i][j], oref[i][j]);
+				spa_assert_not_reached();
+			}
+		}
+	}
+}
+
+/* a chain of n_sections biquads on each channel, unfused runs each biquad of
+ * the chain with its own output buffer, like the nodes of a graph. Fused runs
+ * the chain in one pass like a cascade made by the graph compiler. */
+static void run_cascade1(const char *impl, biquadn_func_t func, bool fused,
+		int n_sections, int n_samples)
+{
+	int i, j, k, n_bq = MAX_BQ;
+	struct biquad *bq[n_bq * n_sections];
+	const float *ip[n_bq];
+	float *op[n_bq];
+	struct timespec ts;
+	uint64_t count, t1, t2;
+	struct dsp_ops ops;
+
+	spa_zero(ops);
+	ops.cpu_flags = cpu_flags;
+
+	for (k = 0; k < n_sections; k++) {
+		for (j = 0; j < n_bq; j++) {
+			struct biquad *b = &bqs[k * n_bq + j];
+			biquad_set(b, BQ_PEAKING, 0.01 + k * 0.02, 0.7, 3.0);
+			bq[k * n_bq + j] = b;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t1 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+	count = 0;
+	for (i = 0; i < MAX_COUNT; i++) {
+		if (fused) {
+			for (j = 0; j < n_bq; j++) {
+				ip[j] = &samp_in[j * MAX_SAMPLES];
+				op[j] = &samp_out[j * MAX_SAMPLES];
+			}
+			func(&ops, bq, n_bq, n_sections, op, ip, n_samples);
+		} else {
+			for (k = 0; k < n_sections; k++) {
+				for (j = 0; j < n_bq; j++) {
+					ip[j] = k == 0 ? &samp_in[j * MAX_SAMPLES] :
+						&samp_out[((k - 1) * n_bq + j) * MAX_SAMPLES];
+					op[j] = &samp_out[(k * n_bq + j) * MAX_SAMPLES];
+				}
+				func(&ops, &bq[k * n_bq], n_bq, 1, op, ip, n_samples);
+			}
+		}
+		count++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	t2 = SPA_TIMESPEC_TO_NSEC(&ts);
+
+	spa_assert(n_results < MAX_RESULTS);
+
+	results[n_results++] = (struct stats) {
+		.n_samples = n_samples,
+		.n_bq = n_bq,
+		.n_sections = n_sections,
+		.perf = count * (uint64_t)SPA_NSEC_PER_SEC / SPA_MAX(t2 - t1, 1u),
+		.name = fused ? "test_cascade_fused" : "test_cascade",
+		.impl = impl
+	};
+}
+
+static void run_cascade(const char *impl, biquadn_func_t func)
+{
+	size_t i;
+
+	for (i = 0; i < SPA_N_ELEMENTS(section_counts); i++) {
+		run_cascade1(impl, func, false, section_counts[i], 1024);
+		run_cascade1(impl, func, true, section_counts[i], 1024);
+	}
+}
+
+static void test_cascade(void)
+{
+	run_cascade("c", dsp_biquadn_run_c);
+#if defined (HAVE_SSE)
+	if (cpu_flags & SPA_CPU_FLAG_SSE)
+		run_cascade("sse", dsp_biquadn_run_sse);
+#endif
+}
+
+static void test_biquadn(void)
+{
+	run_test("test_biquadn", "c", dsp_biquadn_run_c);
+#if defined (HAVE_SSE)
+	if (cpu_flags & SPA_CPU_FLAG_SSE) {
+		check_biquadn("sse", dsp_biquadn_run_sse, 1);
+		check_biquadn("sse", dsp_biquadn_run_sse, MAX_SECTIONS);
+		run_test("test_biquadn", "sse", dsp_biquadn_run_sse);
+	}
+#endif
+}
+
+static int compare_func(const void *_a, const void *_b)
+{
+	const struct stats *a = _a, *b = _b;
+	int diff;
+	if ((diff = strcmp(a->name, b->name)) != 0) return diff;
+	if ((diff = a->n_samples - b->n_samples) != 0) return diff;
+	if ((diff = a->n_bq - b->n_bq) != 0) return diff;
+	if ((diff = a->n_sections - b->n_sections) != 0) return diff;
+	if ((diff = b->perf - a->perf) != 0) return diff;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t i;
+
+	cpu_flags = get_cpu_flags();
+	printf("got get CPU flags %d\n", cpu_flags);
+
+	for (i = 0; i < SPA_N_ELEMENTS(samp_in); i++)
+		samp_in[i] = (float)(drand48() * 2.0 - 1.0);
+
+	test_biquadn();
+	test_cascade();
+
+	qsort(results, n_results, sizeof(struct stats), compare_func);
+
+	for (i = 0; i < n_results; i++) {
+		struct stats *s = &results[i];
+		fprintf(stderr, "%-12."PRIu64" \t%-32.32s %s \t samples %d, biquads %d, sections %d\n",
+				s->perf, s->name, s->impl, s->n_samples, s->n_bq, s->n_sections);
+	}
+	return 0;
+}
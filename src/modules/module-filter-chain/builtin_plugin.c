@@ -11,6 +11,7 @@
 #endif
 #include <unistd.h>
 #include <limits.h>
+#include <pthread.h>
 
 #include <spa/utils/json.h>
 #include <spa/utils/result.h>
@@ -476,13 +477,8 @@ static void bq_activate(void * Instance)
 	}
 }
 
-static void bq_run(void *Instance, unsigned long samples)
+static void bq_update(struct builtin *impl)
 {
-	struct builtin *impl = Instance;
-	struct biquad *bq = &impl->bq;
-	float *out = impl->port[0];
-	float *in = impl->port[1];
-
 	if (impl->type == BQ_NONE) {
 		float b0, b1, b2, a0, a1, a2;
 		b0 = impl->port[5][0];
@@ -502,7 +498,52 @@ static void bq_run(void *Instance, unsigned long samples)
 		if (impl->freq != freq || impl->Q != Q || impl->gain != gain)
 			bq_freq_update(impl, impl->type, freq, Q, gain);
 	}
-	dsp_ops_biquad_run(dsp_ops, bq, out, in, samples);
+}
+
+static void bq_run(void *Instance, unsigned long samples)
+{
+	struct builtin *impl = Instance;
+
+	bq_update(impl);
+	dsp_ops_biquad_run(dsp_ops, &impl->bq, impl->port[0], impl->port[1], samples);
+}
+
+#define MAX_MULTI	16
+
+/* the per channel copies and cascades of biquad nodes are independent,
+ * run them together so that the dsp ops can process them in parallel */
+static void bq_run_multi(void **Instances, uint32_t n_instances, uint32_t n_sections,
+		unsigned long samples)
+{
+	uint32_t max_i = SPA_MIN(n_instances, MAX_MULTI);
+	uint32_t max_j = SPA_MIN(n_sections, MAX_MULTI);
+	struct biquad *bq[max_i * max_j];
+	float *out[max_i];
+	const float *in[max_i];
+	uint32_t i, j, n, m, n_i, n_j;
+
+	for (n = 0; n < n_instances; n += n_i) {
+		n_i = SPA_MIN(n_instances - n, MAX_MULTI);
+
+		for (m = 0; m < n_sections; m += n_j) {
+			n_j = SPA_MIN(n_sections - m, MAX_MULTI);
+
+			for (j = 0; j < n_j; j++) {
+				for (i = 0; i < n_i; i++) {
+					struct builtin *impl = Instances[(m + j) * n_instances + n + i];
+					bq_update(impl);
+					bq[j * n_i + i] = &impl->bq;
+				}
+			}
+			for (i = 0; i < n_i; i++) {
+				struct builtin *first = Instances[n + i];
+				struct builtin *last = Instances[(n_sections - 1) * n_instances + n + i];
+				out[i] = last->port[0];
+				in[i] = m == 0 ? first->port[1] : out[i];
+			}
+			dsp_ops_biquadn_run(dsp_ops, bq, n_i, n_j, out, in, samples);
+		}
+	}
 }
 
 /** bq_lowpass */
@@ -516,6 +557,7 @@ static const struct fc_descriptor bq_lowpass_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -530,6 +572,7 @@ static const struct fc_descriptor bq_highpass_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -544,6 +587,7 @@ static const struct fc_descriptor bq_bandpass_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -558,6 +602,7 @@ static const struct fc_descriptor bq_lowshelf_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -572,6 +617,7 @@ static const struct fc_descriptor bq_highshelf_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -586,6 +632,7 @@ static const struct fc_descriptor bq_peaking_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -600,6 +647,7 @@ static const struct fc_descriptor bq_notch_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -615,6 +663,7 @@ static const struct fc_descriptor bq_allpass_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -629,6 +678,7 @@ static const struct fc_descriptor bq_raw_desc = {
 	.connect_port = builtin_connect_port,
 	.activate = bq_activate,
 	.run = bq_run,
+	.run_multi = bq_run_multi,
 	.cleanup = builtin_cleanup,
 };
 
@@ -637,9 +687,61 @@ struct convolver_impl {
 	unsigned long rate;
 	float *port[64];
 
+	struct convolver_cache *cache;
 	struct convolver *conv;
 };
 
+/* loaded, resampled and partitioned impulse responses, shared between
+ * all convolvers in the process with the same configuration. An entry
+ * lives as long as a convolver uses it. */
+struct convolver_cache {
+	struct spa_list link;
+	int ref;
+	char *key;
+	struct convolver_ir *ir;
+};
+
+static struct spa_list convolver_caches = { &convolver_caches, &convolver_caches };
+static pthread_mutex_t convolver_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct convolver_cache *convolver_cache_find(const char *key)
+{
+	struct convolver_cache *c;
+	spa_list_for_each(c, &convolver_caches, link) {
+		if (spa_streq(c->key, key)) {
+			c->ref++;
+			return c;
+		}
+	}
+	return NULL;
+}
+
+static struct convolver_cache *convolver_cache_add(char *key, struct convolver_ir *ir)
+{
+	struct convolver_cache *c;
+
+	c = calloc(1, sizeof(*c));
+	if (c == NULL)
+		return NULL;
+	c->ref = 1;
+	c->key = key;
+	c->ir = ir;
+	spa_list_append(&convolver_caches, &c->link);
+	return c;
+}
+
+static void convolver_cache_unref(struct convolver_cache *c)
+{
+	pthread_mutex_lock(&convolver_cache_lock);
+	if (--c->ref == 0) {
+		spa_list_remove(&c->link);
+		convolver_ir_unref(c->ir);
+		free(c->key);
+		free(c);
+	}
+	pthread_mutex_unlock(&convolver_cache_lock);
+}
+
 #ifdef HAVE_SNDFILE
 static float *read_samples_from_sf(SNDFILE *f, SF_INFO info, float gain, int delay,
 		int offset, int length, int channel, long unsigned *rate, int *n_samples) {
@@ -866,6 +968,11 @@ static void * convolver_instantiate(const struct fc_descriptor * Descriptor,
 	int resample_quality = RESAMPLE_DEFAULT_QUALITY;
 	float gain = 1.0f;
 	unsigned long rate;
+	struct convolver_cache *cache = NULL;
+	struct convolver_ir *ir = NULL;
+	char *cache_key = NULL;
+	size_t key_size;
+	FILE *f;
 
 	errno = EINVAL;
 	if (config == NULL) {
@@ -964,52 +1071,92 @@ static void * convolver_instantiate(const struct fc_descriptor * Descriptor,
 	if (offset < 0)
 		offset = 0;
 
-	if (spa_streq(filenames[0], "/hilbert")) {
-		samples = create_hilbert(filenames[0], gain, delay, offset,
-				length, &n_samples);
-	} else if (spa_streq(filenames[0], "/dirac")) {
-		samples = create_dirac(filenames[0], gain, delay, offset,
-				length, &n_samples);
+	/* everything that changes the impulse response or its partitions */
+	if ((f = open_memstream(&cache_key, &key_size)) == NULL)
+		goto error;
+	fprintf(f, "%lu:%d:%d:%d:%d:%d:%d:%d:%a", SampleRate, resample_quality,
+			channel, delay, offset, length, blocksize, tailsize, gain);
+	for (i = 0; i < MAX_RATES && filenames[i]; i++)
+		fprintf(f, ":%s", filenames[i]);
+	fclose(f);
+
+	pthread_mutex_lock(&convolver_cache_lock);
+	cache = convolver_cache_find(cache_key);
+	pthread_mutex_unlock(&convolver_cache_lock);
+
+	if (cache != NULL) {
+		pw_log_info("using cached impulse response %s", filenames[0]);
+		free(cache_key);
 	} else {
-		rate = SampleRate;
-		samples = read_closest(filenames, gain, delay, offset,
-				length, channel, &rate, &n_samples);
-		if (samples != NULL && rate != SampleRate)
-			samples = resample_buffer(samples, &n_samples,
-					rate, SampleRate, resample_quality);
-	}
-	if (samples == NULL) {
-		errno = ENOENT;
-		return NULL;
+		/* load without the lock, the other convolvers don't need to wait
+		 * for the file and the resampler */
+		if (spa_streq(filenames[0], "/hilbert")) {
+			samples = create_hilbert(filenames[0], gain, delay, offset,
+					length, &n_samples);
+		} else if (spa_streq(filenames[0], "/dirac")) {
+			samples = create_dirac(filenames[0], gain, delay, offset,
+					length, &n_samples);
+		} else {
+			rate = SampleRate;
+			samples = read_closest(filenames, gain, delay, offset,
+					length, channel, &rate, &n_samples);
+			if (samples != NULL && rate != SampleRate)
+				samples = resample_buffer(samples, &n_samples,
+						rate, SampleRate, resample_quality);
+		}
+		if (samples != NULL) {
+			if (blocksize <= 0)
+				blocksize = SPA_CLAMP(n_samples, 64, 256);
+			if (tailsize <= 0)
+				tailsize = SPA_CLAMP(4096, blocksize, 32768);
+
+			pw_log_info("using n_samples:%u %d:%d blocksize", n_samples,
+					blocksize, tailsize);
+
+			ir = convolver_ir_new(dsp_ops, blocksize, tailsize,
+					(const float **)&samples, 1, n_samples);
+			free(samples);
+		}
+		pthread_mutex_lock(&convolver_cache_lock);
+		if (ir != NULL && (cache = convolver_cache_find(cache_key)) != NULL) {
+			pw_log_info("impulse response %s was loaded by another convolver",
+					filenames[0]);
+			convolver_ir_unref(ir);
+			free(cache_key);
+		} else if (ir == NULL || (cache = convolver_cache_add(cache_key, ir)) == NULL) {
+			if (ir)
+				convolver_ir_unref(ir);
+			free(cache_key);
+		}
+		pthread_mutex_unlock(&convolver_cache_lock);
 	}
 
 	for (i = 0; i < MAX_RATES; i++)
-		if (filenames[i])
-			free(filenames[i]);
-
-	if (blocksize <= 0)
-		blocksize = SPA_CLAMP(n_samples, 64, 256);
-	if (tailsize <= 0)
-		tailsize = SPA_CLAMP(4096, blocksize, 32768);
+		free(filenames[i]);
 
-	pw_log_info("using n_samples:%u %d:%d blocksize", n_samples,
-			blocksize, tailsize);
+	if (cache == NULL) {
+		errno = ENOENT;
+		return NULL;
+	}
 
 	impl = calloc(1, sizeof(*impl));
 	if (impl == NULL)
-		goto error;
+		goto error_unref;
 
 	impl->rate = SampleRate;
+	impl->cache = cache;
 
-	impl->conv = convolver_new(dsp_ops, blocksize, tailsize, samples, n_samples);
+	impl->conv = convolver_new_ir(cache->ir);
 	if (impl->conv == NULL)
-		goto error;
-
-	free(samples);
+		goto error_unref;
 
 	return impl;
 error:
-	free(samples);
+	for (i = 0; i < MAX_RATES; i++)
+		free(filenames[i]);
+	return NULL;
+error_unref:
+	convolver_cache_unref(cache);
 	free(impl);
 	return NULL;
 }
@@ -1026,6 +1173,8 @@ static void convolver_cleanup(void * Instance)
 	struct convolver_impl *impl = Instance;
 	if (impl->conv)
 		convolver_free(impl->conv);
+	if (impl->cache)
+		convolver_cache_unref(impl->cache);
 	free(impl);
 }
 
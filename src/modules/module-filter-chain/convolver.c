@@ -7,16 +7,33 @@
 #include "convolver.h"
 
 #include <spa/utils/defs.h>
+#include <spa/utils/atomic.h>
 
 #include <math.h>
 
 static struct dsp_ops *dsp;
 
+#define MAX_IR	4
+
+/* the frequency domain partitions of the impulse responses for one
+ * block size, read-only once made and shared by all convolvers
+ * that are made from the same convolver_ir */
+struct convolver1_ir {
+	int blockSize;
+	int segSize;
+	int segCount;
+	int fftComplexSize;
+	int n_ir;
+
+	float **segmentsIr;
+};
+
 struct convolver1 {
 	int blockSize;
 	int segSize;
 	int segCount;
 	int fftComplexSize;
+	int n_ir;
 
 	float **segments;
 	float **segmentsIr;
@@ -26,9 +43,9 @@ struct convolver1 {
 	void *fft;
 	void *ifft;
 
-	float *pre_mult;
-	float *conv;
-	float *overlap;
+	float *pre_mult[MAX_IR];
+	float *conv[MAX_IR];
+	float *overlap[MAX_IR];
 
 	float *inputBuffer;
 	int inputBufferFill;
@@ -81,29 +98,63 @@ static void convolver1_reset(struct convolver1 *conv)
 	int i;
 	for (i = 0; i < conv->segCount; i++)
 		fft_cpx_clear(conv->segments[i], conv->fftComplexSize);
-	dsp_ops_clear(dsp, conv->overlap, conv->blockSize);
-	dsp_ops_clear(dsp, conv->inputBuffer, conv->segSize);
-	fft_cpx_clear(conv->pre_mult, conv->fftComplexSize);
-	fft_cpx_clear(conv->conv, conv->fftComplexSize);
+	for (i = 0; i < conv->n_ir && conv->segCount > 0; i++) {
+		dsp_ops_clear(dsp, conv->overlap[i], conv->blockSize);
+		fft_cpx_clear(conv->pre_mult[i], conv->fftComplexSize);
+		fft_cpx_clear(conv->conv[i], conv->fftComplexSize);
+	}
+	if (conv->inputBuffer)
+		dsp_ops_clear(dsp, conv->inputBuffer, conv->segSize);
 	conv->inputBufferFill = 0;
 	conv->current = 0;
 }
 
-static struct convolver1 *convolver1_new(int block, const float *ir, int irlen)
+static int ir_trim(const float *ir[], int n_ir, int irlen)
+{
+	int i, len, max = 0;
+	for (i = 0; i < n_ir; i++) {
+		len = irlen;
+		while (len > 0 && fabs(ir[i][len-1]) < 0.000001f)
+			len--;
+		max = SPA_MAX(max, len);
+	}
+	return max;
+}
+
+static void convolver1_ir_free(struct convolver1_ir *ir)
 {
-	struct convolver1 *conv;
 	int i;
+	for (i = 0; i < ir->segCount * ir->n_ir; i++) {
+		if (ir->segmentsIr)
+			fft_cpx_free(ir->segmentsIr[i]);
+	}
+	free(ir->segmentsIr);
+	free(ir);
+}
+
+/* all n_ir impulse responses are convolved with the same input, the
+ * input spectrum is only calculated once */
+static struct convolver1_ir *convolver1_ir_new(int block, const float *ir[], int n_ir,
+		int offset, int irlen)
+{
+	struct convolver1_ir *conv;
+	const float *p[MAX_IR];
+	float *fft_buffer = NULL;
+	void *fft = NULL;
+	int i, j;
 
-	if (block == 0)
+	if (block == 0 || n_ir > MAX_IR)
 		return NULL;
 
-	while (irlen > 0 && fabs(ir[irlen-1]) < 0.000001f)
-		irlen--;
+	for (j = 0; j < n_ir; j++)
+		p[j] = ir[j] + offset;
+	irlen = ir_trim(p, n_ir, irlen);
 
 	conv = calloc(1, sizeof(*conv));
 	if (conv == NULL)
 		return NULL;
 
+	conv->n_ir = n_ir;
 	if (irlen == 0)
 		return conv;
 
@@ -112,6 +163,66 @@ static struct convolver1 *convolver1_new(int block, const float *ir, int irlen)
 	conv->segCount = (irlen + conv->blockSize-1) / conv->blockSize;
 	conv->fftComplexSize = (conv->segSize / 2) + 1;
 
+	fft = dsp_ops_fft_new(dsp, conv->segSize, true);
+	if (fft == NULL)
+		goto error;
+	fft_buffer = fft_alloc(conv->segSize);
+	if (fft_buffer == NULL)
+		goto error;
+
+	conv->segmentsIr = calloc(sizeof(float*), conv->segCount * n_ir);
+	if (conv->segmentsIr == NULL)
+		goto error;
+
+	for (i = 0; i < conv->segCount; i++) {
+		int left = irlen - (i * conv->blockSize);
+		int copy = SPA_MIN(conv->blockSize, left);
+
+		for (j = 0; j < n_ir; j++) {
+			float **segIr = &conv->segmentsIr[j * conv->segCount];
+
+			segIr[i] = fft_cpx_alloc(conv->fftComplexSize);
+
+			dsp_ops_copy(dsp, fft_buffer, &p[j][i * conv->blockSize], copy);
+			if (copy < conv->segSize)
+				dsp_ops_clear(dsp, fft_buffer + copy, conv->segSize - copy);
+
+		        dsp_ops_fft_run(dsp, fft, 1, fft_buffer, segIr[i]);
+		}
+	}
+	dsp_ops_fft_free(dsp, fft);
+	fft_free(fft_buffer);
+
+	return conv;
+error:
+	if (fft)
+		dsp_ops_fft_free(dsp, fft);
+	fft_free(fft_buffer);
+	convolver1_ir_free(conv);
+	return NULL;
+}
+
+static void convolver1_free(struct convolver1 *conv);
+
+static struct convolver1 *convolver1_new(const struct convolver1_ir *ir)
+{
+	struct convolver1 *conv;
+	int i, j, n_ir = ir->n_ir;
+
+	conv = calloc(1, sizeof(*conv));
+	if (conv == NULL)
+		return NULL;
+
+	conv->n_ir = n_ir;
+	if (ir->segCount == 0)
+		return conv;
+
+	conv->blockSize = ir->blockSize;
+	conv->segSize = ir->segSize;
+	conv->segCount = ir->segCount;
+	conv->fftComplexSize = ir->fftComplexSize;
+	conv->segmentsIr = ir->segmentsIr;
+
 	conv->fft = dsp_ops_fft_new(dsp, conv->segSize, true);
 	if (conv->fft == NULL)
 		goto error;
@@ -124,37 +235,24 @@ static struct convolver1 *convolver1_new(int block, const float *ir, int irlen)
 		goto error;
 
 	conv->segments = calloc(sizeof(float*), conv->segCount);
-	conv->segmentsIr = calloc(sizeof(float*), conv->segCount);
-
-	for (i = 0; i < conv->segCount; i++) {
-		int left = irlen - (i * conv->blockSize);
-		int copy = SPA_MIN(conv->blockSize, left);
+	if (conv->segments == NULL)
+		goto error;
 
+	for (i = 0; i < conv->segCount; i++)
 		conv->segments[i] = fft_cpx_alloc(conv->fftComplexSize);
-		conv->segmentsIr[i] = fft_cpx_alloc(conv->fftComplexSize);
-
-		dsp_ops_copy(dsp, conv->fft_buffer, &ir[i * conv->blockSize], copy);
-		if (copy < conv->segSize)
-			dsp_ops_clear(dsp, conv->fft_buffer + copy, conv->segSize - copy);
 
-	        dsp_ops_fft_run(dsp, conv->fft, 1, conv->fft_buffer, conv->segmentsIr[i]);
+	for (j = 0; j < n_ir; j++) {
+		conv->pre_mult[j] = fft_cpx_alloc(conv->fftComplexSize);
+		conv->conv[j] = fft_cpx_alloc(conv->fftComplexSize);
+		conv->overlap[j] = fft_alloc(conv->blockSize);
 	}
-	conv->pre_mult = fft_cpx_alloc(conv->fftComplexSize);
-	conv->conv = fft_cpx_alloc(conv->fftComplexSize);
-	conv->overlap = fft_alloc(conv->blockSize);
 	conv->inputBuffer = fft_alloc(conv->segSize);
 	conv->scale = 1.0f / conv->segSize;
 	convolver1_reset(conv);
 
 	return conv;
 error:
-	if (conv->fft)
-		dsp_ops_fft_free(dsp, conv->fft);
-	if (conv->ifft)
-		dsp_ops_fft_free(dsp, conv->ifft);
-	if (conv->fft_buffer)
-		fft_free(conv->fft_buffer);
-	free(conv);
+	convolver1_free(conv);
 	return NULL;
 }
 
@@ -162,8 +260,8 @@ static void convolver1_free(struct convolver1 *conv)
 {
 	int i;
 	for (i = 0; i < conv->segCount; i++) {
-		fft_cpx_free(conv->segments[i]);
-		fft_cpx_free(conv->segmentsIr[i]);
+		if (conv->segments)
+			fft_cpx_free(conv->segments[i]);
 	}
 	if (conv->fft)
 		dsp_ops_fft_free(dsp, conv->fft);
@@ -172,20 +270,22 @@ static void convolver1_free(struct convolver1 *conv)
 	if (conv->fft_buffer)
 		fft_free(conv->fft_buffer);
 	free(conv->segments);
-	free(conv->segmentsIr);
-	fft_cpx_free(conv->pre_mult);
-	fft_cpx_free(conv->conv);
-	fft_free(conv->overlap);
+	for (i = 0; i < conv->n_ir; i++) {
+		fft_cpx_free(conv->pre_mult[i]);
+		fft_cpx_free(conv->conv[i]);
+		fft_free(conv->overlap[i]);
+	}
 	fft_free(conv->inputBuffer);
 	free(conv);
 }
 
-static int convolver1_run(struct convolver1 *conv, const float *input, float *output, int len)
+static int convolver1_run(struct convolver1 *conv, const float *input, float *output[], int len)
 {
-	int i, processed = 0;
+	int i, j, processed = 0;
 
 	if (conv == NULL || conv->segCount == 0) {
-		dsp_ops_clear(dsp, output, len);
+		for (j = 0; conv != NULL && j < conv->n_ir; j++)
+			dsp_ops_clear(dsp, output[j], len);
 		return len;
 	}
 
@@ -199,51 +299,57 @@ static int convolver1_run(struct convolver1 *conv, const float *input, float *ou
 
 		dsp_ops_fft_run(dsp, conv->fft, 1, conv->inputBuffer, conv->segments[conv->current]);
 
-		if (conv->segCount > 1) {
-			if (conv->inputBufferFill == 0) {
-				int indexAudio = (conv->current + 1) % conv->segCount;
+		conv->inputBufferFill += processing;
 
-				dsp_ops_fft_cmul(dsp, conv->fft, conv->pre_mult,
-						conv->segmentsIr[1],
-						conv->segments[indexAudio],
-						conv->fftComplexSize, conv->scale);
+		for (j = 0; j < conv->n_ir; j++) {
+			float **segIr = &conv->segmentsIr[j * conv->segCount];
 
-				for (i = 2; i < conv->segCount; i++) {
-					indexAudio = (conv->current + i) % conv->segCount;
+			if (conv->segCount > 1) {
+				if (inputBufferPos == 0) {
+					int indexAudio = (conv->current + 1) % conv->segCount;
 
-					dsp_ops_fft_cmuladd(dsp, conv->fft,
-							conv->pre_mult,
-							conv->pre_mult,
-							conv->segmentsIr[i],
+					dsp_ops_fft_cmul(dsp, conv->fft, conv->pre_mult[j],
+							segIr[1],
 							conv->segments[indexAudio],
 							conv->fftComplexSize, conv->scale);
+
+					for (i = 2; i < conv->segCount; i++) {
+						indexAudio = (conv->current + i) % conv->segCount;
+
+						dsp_ops_fft_cmuladd(dsp, conv->fft,
+								conv->pre_mult[j],
+								conv->pre_mult[j],
+								segIr[i],
+								conv->segments[indexAudio],
+								conv->fftComplexSize, conv->scale);
+					}
 				}
+				dsp_ops_fft_cmuladd(dsp, conv->fft,
+						conv->conv[j],
+						conv->pre_mult[j],
+						conv->segments[conv->current],
+						segIr[0],
+						conv->fftComplexSize, conv->scale);
+			} else {
+				dsp_ops_fft_cmul(dsp, conv->fft,
+						conv->conv[j],
+						conv->segments[conv->current],
+						segIr[0],
+						conv->fftComplexSize, conv->scale);
 			}
-			dsp_ops_fft_cmuladd(dsp, conv->fft,
-					conv->conv,
-					conv->pre_mult,
-					conv->segments[conv->current],
-					conv->segmentsIr[0],
-					conv->fftComplexSize, conv->scale);
-		} else {
-			dsp_ops_fft_cmul(dsp, conv->fft,
-					conv->conv,
-					conv->segments[conv->current],
-					conv->segmentsIr[0],
-					conv->fftComplexSize, conv->scale);
-		}
 
-		dsp_ops_fft_run(dsp, conv->ifft, -1, conv->conv, conv->fft_buffer);
+			dsp_ops_fft_run(dsp, conv->ifft, -1, conv->conv[j], conv->fft_buffer);
 
-		dsp_ops_sum(dsp, output + processed, conv->fft_buffer + inputBufferPos,
-				conv->overlap + inputBufferPos, processing);
+			dsp_ops_sum(dsp, output[j] + processed, conv->fft_buffer + inputBufferPos,
+					conv->overlap[j] + inputBufferPos, processing);
+
+			if (conv->inputBufferFill == conv->blockSize)
+				dsp_ops_copy(dsp, conv->overlap[j], conv->fft_buffer + conv->blockSize,
+						conv->blockSize);
+		}
 
-		conv->inputBufferFill += processing;
 		if (conv->inputBufferFill == conv->blockSize) {
 			conv->inputBufferFill = 0;
-
-			dsp_ops_copy(dsp, conv->overlap, conv->fft_buffer + conv->blockSize, conv->blockSize);
-
 			conv->current = (conv->current > 0) ? (conv->current - 1) : (conv->segCount - 1);
 		}
 
@@ -252,17 +358,30 @@ static int convolver1_run(struct convolver1 *conv, const float *input, float *ou
 	return len;
 }
 
+struct convolver_ir
+{
+	int ref;
+	int headBlockSize;
+	int tailBlockSize;
+	int n_ir;
+	struct convolver1_ir *head;
+	struct convolver1_ir *tail0;
+	struct convolver1_ir *tail;
+};
+
 struct convolver
 {
+	struct convolver_ir *ir;
 	int headBlockSize;
 	int tailBlockSize;
+	int n_ir;
 	struct convolver1 *headConvolver;
 	struct convolver1 *tailConvolver0;
-	float *tailOutput0;
-	float *tailPrecalculated0;
+	float *tailOutput0[MAX_IR];
+	float *tailPrecalculated0[MAX_IR];
 	struct convolver1 *tailConvolver;
-	float *tailOutput;
-	float *tailPrecalculated;
+	float *tailOutput[MAX_IR];
+	float *tailPrecalculated[MAX_IR];
 	float *tailInput;
 	int tailInputFill;
 	int precalculatedPos;
@@ -270,64 +389,132 @@ struct convolver
 
 void convolver_reset(struct convolver *conv)
 {
+	int i;
 	if (conv->headConvolver)
 		convolver1_reset(conv->headConvolver);
 	if (conv->tailConvolver0) {
 		convolver1_reset(conv->tailConvolver0);
-		dsp_ops_clear(dsp, conv->tailOutput0, conv->tailBlockSize);
-		dsp_ops_clear(dsp, conv->tailPrecalculated0, conv->tailBlockSize);
+		for (i = 0; i < conv->n_ir; i++) {
+			dsp_ops_clear(dsp, conv->tailOutput0[i], conv->tailBlockSize);
+			dsp_ops_clear(dsp, conv->tailPrecalculated0[i], conv->tailBlockSize);
+		}
 	}
 	if (conv->tailConvolver) {
 		convolver1_reset(conv->tailConvolver);
-		dsp_ops_clear(dsp, conv->tailOutput, conv->tailBlockSize);
-		dsp_ops_clear(dsp, conv->tailPrecalculated, conv->tailBlockSize);
+		for (i = 0; i < conv->n_ir; i++) {
+			dsp_ops_clear(dsp, conv->tailOutput[i], conv->tailBlockSize);
+			dsp_ops_clear(dsp, conv->tailPrecalculated[i], conv->tailBlockSize);
+		}
 	}
 	conv->tailInputFill = 0;
 	conv->precalculatedPos = 0;
 }
 
-struct convolver *convolver_new(struct dsp_ops *dsp_ops, int head_block, int tail_block, const float *ir, int irlen)
+struct convolver_ir *convolver_ir_new(struct dsp_ops *dsp_ops, int head_block, int tail_block,
+		const float *ir[], int n_ir, int irlen)
 {
-	struct convolver *conv;
-	int head_ir_len;
+	struct convolver_ir *conv;
 
 	dsp = dsp_ops;
 
-	if (head_block == 0 || tail_block == 0)
+	if (head_block == 0 || tail_block == 0 || n_ir < 1 || n_ir > MAX_IR)
 		return NULL;
 
 	head_block = SPA_MAX(1, head_block);
 	if (head_block > tail_block)
 		SPA_SWAP(head_block, tail_block);
 
-	while (irlen > 0 && fabs(ir[irlen-1]) < 0.000001f)
-		irlen--;
+	irlen = ir_trim(ir, n_ir, irlen);
 
 	conv = calloc(1, sizeof(*conv));
 	if (conv == NULL)
 		return NULL;
 
+	conv->ref = 1;
+	conv->n_ir = n_ir;
 	if (irlen == 0)
 		return conv;
 
 	conv->headBlockSize = next_power_of_two(head_block);
 	conv->tailBlockSize = next_power_of_two(tail_block);
 
-	head_ir_len = SPA_MIN(irlen, conv->tailBlockSize);
-	conv->headConvolver = convolver1_new(conv->headBlockSize, ir, head_ir_len);
+	conv->head = convolver1_ir_new(conv->headBlockSize, ir, n_ir, 0,
+			SPA_MIN(irlen, conv->tailBlockSize));
+	if (conv->head == NULL)
+		goto error;
 
 	if (irlen > conv->tailBlockSize) {
 		int conv1IrLen = SPA_MIN(irlen - conv->tailBlockSize, conv->tailBlockSize);
-		conv->tailConvolver0 = convolver1_new(conv->headBlockSize, ir + conv->tailBlockSize, conv1IrLen);
-		conv->tailOutput0 = fft_alloc(conv->tailBlockSize);
-		conv->tailPrecalculated0 = fft_alloc(conv->tailBlockSize);
+		conv->tail0 = convolver1_ir_new(conv->headBlockSize, ir, n_ir,
+				conv->tailBlockSize, conv1IrLen);
+		if (conv->tail0 == NULL)
+			goto error;
 	}
-
 	if (irlen > 2 * conv->tailBlockSize) {
 		int tailIrLen = irlen - (2 * conv->tailBlockSize);
-		conv->tailConvolver = convolver1_new(conv->tailBlockSize, ir + (2 * conv->tailBlockSize), tailIrLen);
-		conv->tailOutput = fft_alloc(conv->tailBlockSize);
-		conv->tailPrecalculated = fft_alloc(conv->tailBlockSize);
+		conv->tail = convolver1_ir_new(conv->tailBlockSize, ir, n_ir,
+				2 * conv->tailBlockSize, tailIrLen);
+		if (conv->tail == NULL)
+			goto error;
+	}
+	return conv;
+error:
+	convolver_ir_unref(conv);
+	return NULL;
+}
+
+struct convolver_ir *convolver_ir_ref(struct convolver_ir *ir)
+{
+	SPA_ATOMIC_INC(ir->ref);
+	return ir;
+}
+
+void convolver_ir_unref(struct convolver_ir *ir)
+{
+	if (SPA_ATOMIC_DEC(ir->ref) > 0)
+		return;
+	if (ir->head)
+		convolver1_ir_free(ir->head);
+	if (ir->tail0)
+		convolver1_ir_free(ir->tail0);
+	if (ir->tail)
+		convolver1_ir_free(ir->tail);
+	free(ir);
+}
+
+struct convolver *convolver_new_ir(struct convolver_ir *ir)
+{
+	struct convolver *conv;
+	int i;
+
+	conv = calloc(1, sizeof(*conv));
+	if (conv == NULL)
+		return NULL;
+
+	conv->ir = convolver_ir_ref(ir);
+	conv->n_ir = ir->n_ir;
+	if (ir->head == NULL)
+		return conv;
+
+	conv->headBlockSize = ir->headBlockSize;
+	conv->tailBlockSize = ir->tailBlockSize;
+
+	conv->headConvolver = convolver1_new(ir->head);
+
+	if (ir->tail0) {
+		conv->tailConvolver0 = convolver1_new(ir->tail0);
+		for (i = 0; i < conv->n_ir; i++) {
+			conv->tailOutput0[i] = fft_alloc(conv->tailBlockSize);
+			conv->tailPrecalculated0[i] = fft_alloc(conv->tailBlockSize);
+		}
+	}
+
+	if (ir->tail) {
+		conv->tailConvolver = convolver1_new(ir->tail);
+		for (i = 0; i < conv->n_ir; i++) {
+			conv->tailOutput[i] = fft_alloc(conv->tailBlockSize);
+			conv->tailPrecalculated[i] = fft_alloc(conv->tailBlockSize);
+		}
 	}
 
 	if (conv->tailConvolver0 || conv->tailConvolver)
@@ -338,24 +525,55 @@ struct convolver *convolver_new(struct dsp_ops *dsp_ops, int head_block, int tai
 	return conv;
 }
 
+struct convolver *convolver_new_n(struct dsp_ops *dsp_ops, int head_block, int tail_block,
+		const float *ir[], int n_ir, int irlen)
+{
+	struct convolver_ir *cir;
+	struct convolver *conv;
+
+	if ((cir = convolver_ir_new(dsp_ops, head_block, tail_block, ir, n_ir, irlen)) == NULL)
+		return NULL;
+	conv = convolver_new_ir(cir);
+	convolver_ir_unref(cir);
+	return conv;
+}
+
+struct convolver *convolver_new(struct dsp_ops *dsp_ops, int head_block, int tail_block, const float *ir, int irlen)
+{
+	return convolver_new_n(dsp_ops, head_block, tail_block, &ir, 1, irlen);
+}
+
 void convolver_free(struct convolver *conv)
 {
+	int i;
 	if (conv->headConvolver)
 		convolver1_free(conv->headConvolver);
 	if (conv->tailConvolver0)
 		convolver1_free(conv->tailConvolver0);
 	if (conv->tailConvolver)
 		convolver1_free(conv->tailConvolver);
-	fft_free(conv->tailOutput0);
-	fft_free(conv->tailPrecalculated0);
-	fft_free(conv->tailOutput);
-	fft_free(conv->tailPrecalculated);
+	for (i = 0; i < conv->n_ir; i++) {
+		fft_free(conv->tailOutput0[i]);
+		fft_free(conv->tailPrecalculated0[i]);
+		fft_free(conv->tailOutput[i]);
+		fft_free(conv->tailPrecalculated[i]);
+	}
 	fft_free(conv->tailInput);
+	convolver_ir_unref(conv->ir);
 	free(conv);
 }
 
-int convolver_run(struct convolver *conv, const float *input, float *output, int length)
+int convolver_run_n(struct convolver *conv, const float *input, float *output[], int length)
 {
+	float *out[MAX_IR];
+	int i;
+
+	if (conv->headConvolver == NULL) {
+		for (i = 0; i < conv->n_ir; i++)
+			dsp_ops_clear(dsp, output[i], length);
+		return 0;
+	}
+
 	convolver1_run(conv->headConvolver, input, output, length);
 
 	if (conv->tailInput) {
@@ -365,32 +583,38 @@ int convolver_run(struct convolver *conv, const float *input, float *output, int
 			int remaining = length - processed;
 			int processing = SPA_MIN(remaining, conv->headBlockSize - (conv->tailInputFill % conv->headBlockSize));
 
-			if (conv->tailPrecalculated0)
-				dsp_ops_sum(dsp, &output[processed], &output[processed],
-						&conv->tailPrecalculated0[conv->precalculatedPos],
-						processing);
-			if (conv->tailPrecalculated)
-				dsp_ops_sum(dsp, &output[processed], &output[processed],
-						&conv->tailPrecalculated[conv->precalculatedPos],
-						processing);
+			for (i = 0; i < conv->n_ir; i++) {
+				if (conv->tailPrecalculated0[i])
+					dsp_ops_sum(dsp, &output[i][processed], &output[i][processed],
+							&conv->tailPrecalculated0[i][conv->precalculatedPos],
+							processing);
+				if (conv->tailPrecalculated[i])
+					dsp_ops_sum(dsp, &output[i][processed], &output[i][processed],
+							&conv->tailPrecalculated[i][conv->precalculatedPos],
+							processing);
+			}
 			conv->precalculatedPos += processing;
 
 			dsp_ops_copy(dsp, conv->tailInput + conv->tailInputFill, input + processed, processing);
 			conv->tailInputFill += processing;
 
-			if (conv->tailPrecalculated0 && (conv->tailInputFill % conv->headBlockSize == 0)) {
+			if (conv->tailConvolver0 && (conv->tailInputFill % conv->headBlockSize == 0)) {
 				int blockOffset = conv->tailInputFill - conv->headBlockSize;
+				for (i = 0; i < conv->n_ir; i++)
+					out[i] = conv->tailOutput0[i] + blockOffset;
 				convolver1_run(conv->tailConvolver0,
 						conv->tailInput + blockOffset,
-						conv->tailOutput0 + blockOffset,
-						conv->headBlockSize);
-				if (conv->tailInputFill == conv->tailBlockSize)
-					SPA_SWAP(conv->tailPrecalculated0, conv->tailOutput0);
+						out, conv->headBlockSize);
+				if (conv->tailInputFill == conv->tailBlockSize) {
+					for (i = 0; i < conv->n_ir; i++)
+						SPA_SWAP(conv->tailPrecalculated0[i], conv->tailOutput0[i]);
+				}
 			}
 
-			if (conv->tailPrecalculated &&
+			if (conv->tailConvolver &&
 			    conv->tailInputFill == conv->tailBlockSize) {
-				SPA_SWAP(conv->tailPrecalculated, conv->tailOutput);
+				for (i = 0; i < conv->n_ir; i++)
+					SPA_SWAP(conv->tailPrecalculated[i], conv->tailOutput[i]);
 				convolver1_run(conv->tailConvolver, conv->tailInput,
 						conv->tailOutput, conv->tailBlockSize);
 			}
@@ -403,3 +627,8 @@ int convolver_run(struct convolver *conv, const float *input, float *output, int
 	}
 	return 0;
 }
+
+int convolver_run(struct convolver *conv, const float *input, float *output, int length)
+{
+	return convolver_run_n(conv, input, &output, length);
+}
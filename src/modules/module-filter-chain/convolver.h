@@ -8,7 +8,19 @@
 #include "dsp-ops.h"
 
 struct convolver *convolver_new(struct dsp_ops *dsp, int block, int tail, const float *ir, int irlen);
+struct convolver *convolver_new_n(struct dsp_ops *dsp, int block, int tail,
+		const float *ir[], int n_ir, int irlen);
 void convolver_free(struct convolver *conv);
 
+/* the impulse responses in the frequency domain, can be shared by
+ * several convolvers with the same block sizes */
+struct convolver_ir *convolver_ir_new(struct dsp_ops *dsp, int block, int tail,
+		const float *ir[], int n_ir, int irlen);
+struct convolver_ir *convolver_ir_ref(struct convolver_ir *ir);
+void convolver_ir_unref(struct convolver_ir *ir);
+
+struct convolver *convolver_new_ir(struct convolver_ir *ir);
+
 void convolver_reset(struct convolver *conv);
 int convolver_run(struct convolver *conv, const float *input, float *output, int length);
+int convolver_run_n(struct convolver *conv, const float *input, float *output[], int length);
@@ -108,6 +108,19 @@ void dsp_biquad_run_c(struct dsp_ops *ops, struct biquad *bq,
 #undef F
 }
 
+void dsp_biquadn_run_c(struct dsp_ops *ops, struct biquad *bq[], uint32_t n_bq,
+		uint32_t n_sections, float *out[], const float *in[], uint32_t n_samples)
+{
+	uint32_t i, j;
+	for (i = 0; i < n_bq; i++) {
+		const float *src = in[i];
+		for (j = 0; j < n_sections; j++) {
+			dsp_biquad_run_c(ops, bq[j * n_bq + i], out[i], src, n_samples);
+			src = out[i];
+		}
+	}
+}
+
 void dsp_sum_c(struct dsp_ops *ops, float * dst,
 		const float * SPA_RESTRICT a, const float * SPA_RESTRICT b, uint32_t n_samples)
 {
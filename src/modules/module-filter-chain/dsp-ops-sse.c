@@ -70,6 +70,94 @@ void dsp_mix_gain_sse(struct dsp_ops *ops,
 	}
 }
 
+#define MAX_SECTIONS	8
+
+static void dsp_biquad4_run_sse(struct dsp_ops *ops, struct biquad *bq[], uint32_t n_bq,
+		uint32_t n_sections, float *out[], const float *in[], uint32_t n_samples)
+{
+	__m128 x, y, x1[MAX_SECTIONS], x2[MAX_SECTIONS];
+	__m128 b0[MAX_SECTIONS], b1[MAX_SECTIONS], b2[MAX_SECTIONS];
+	__m128 a1[MAX_SECTIONS], a2[MAX_SECTIONS];
+	__m128 s[4];
+	uint32_t i, j, k, unrolled;
+	float t1[4], t2[4];
+
+	for (k = 0; k < n_sections; k++) {
+		struct biquad **q = &bq[k * n_bq];
+		b0[k] = _mm_setr_ps(q[0]->b0, q[1]->b0, q[2]->b0, q[3]->b0);
+		b1[k] = _mm_setr_ps(q[0]->b1, q[1]->b1, q[2]->b1, q[3]->b1);
+		b2[k] = _mm_setr_ps(q[0]->b2, q[1]->b2, q[2]->b2, q[3]->b2);
+		a1[k] = _mm_setr_ps(q[0]->a1, q[1]->a1, q[2]->a1, q[3]->a1);
+		a2[k] = _mm_setr_ps(q[0]->a2, q[1]->a2, q[2]->a2, q[3]->a2);
+		x1[k] = _mm_setr_ps(q[0]->x1, q[1]->x1, q[2]->x1, q[3]->x1);
+		x2[k] = _mm_setr_ps(q[0]->x2, q[1]->x2, q[2]->x2, q[3]->x2);
+	}
+
+	unrolled = n_samples & ~3;
+
+	for (i = 0; i < unrolled; i += 4) {
+		/* 4 samples of each filter, transposed so that each vector
+		 * holds one sample of all 4 filters */
+		s[0] = _mm_loadu_ps(&in[0][i]);
+		s[1] = _mm_loadu_ps(&in[1][i]);
+		s[2] = _mm_loadu_ps(&in[2][i]);
+		s[3] = _mm_loadu_ps(&in[3][i]);
+		_MM_TRANSPOSE4_PS(s[0], s[1], s[2], s[3]);
+
+		for (j = 0; j < 4; j++) {
+			x = s[j];
+			for (k = 0; k < n_sections; k++) {
+				y = _mm_add_ps(_mm_mul_ps(b0[k], x), x1[k]);
+				x1[k] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1[k], x), _mm_mul_ps(a1[k], y)), x2[k]);
+				x2[k] = _mm_sub_ps(_mm_mul_ps(b2[k], x), _mm_mul_ps(a2[k], y));
+				x = y;
+			}
+			s[j] = x;
+		}
+
+		_MM_TRANSPOSE4_PS(s[0], s[1], s[2], s[3]);
+		_mm_storeu_ps(&out[0][i], s[0]);
+		_mm_storeu_ps(&out[1][i], s[1]);
+		_mm_storeu_ps(&out[2][i], s[2]);
+		_mm_storeu_ps(&out[3][i], s[3]);
+	}
+
+	/* the remaining samples are done per filter, this also flushes the
+	 * denormals from the state */
+	for (k = 0; k < n_sections; k++) {
+		struct biquad **q = &bq[k * n_bq];
+		_mm_storeu_ps(t1, x1[k]);
+		_mm_storeu_ps(t2, x2[k]);
+		for (j = 0; j < 4; j++) {
+			q[j]->x1 = t1[j];
+			q[j]->x2 = t2[j];
+			dsp_biquad_run_c(ops, q[j], &out[j][i],
+					k == 0 ? &in[j][i] : &out[j][i], n_samples - i);
+		}
+	}
+}
+
+void dsp_biquadn_run_sse(struct dsp_ops *ops, struct biquad *bq[], uint32_t n_bq,
+		uint32_t n_sections, float *out[], const float *in[], uint32_t n_samples)
+{
+	uint32_t i, j, n;
+
+	for (i = 0; i + 4 <= n_bq; i += 4) {
+		for (j = 0; j < n_sections; j += n) {
+			n = SPA_MIN(n_sections - j, MAX_SECTIONS);
+			dsp_biquad4_run_sse(ops, &bq[j * n_bq + i], n_bq, n, &out[i],
+					j == 0 ? &in[i] : (const float **)&out[i], n_samples);
+		}
+	}
+	for (; i < n_bq; i++) {
+		const float *src = in[i];
+		for (j = 0; j < n_sections; j++) {
+			dsp_biquad_run_c(ops, bq[j * n_bq + i], out[i], src, n_samples);
+			src = out[i];
+		}
+	}
+}
+
 void dsp_sum_sse(struct dsp_ops *ops, float *r, const float *a, const float *b, uint32_t n_samples)
 {
 	uint32_t n, unrolled;
@@ -26,6 +26,7 @@ static struct dsp_info dsp_table[] =
 		.funcs.copy = dsp_copy_c,
 		.funcs.mix_gain = dsp_mix_gain_sse,
 		.funcs.biquad_run = dsp_biquad_run_c,
+		.funcs.biquadn_run = dsp_biquadn_run_sse,
 		.funcs.sum = dsp_sum_avx,
 		.funcs.fft_new = dsp_fft_new_c,
 		.funcs.fft_free = dsp_fft_free_c,
@@ -40,6 +41,7 @@ static struct dsp_info dsp_table[] =
 		.funcs.copy = dsp_copy_c,
 		.funcs.mix_gain = dsp_mix_gain_sse,
 		.funcs.biquad_run = dsp_biquad_run_c,
+		.funcs.biquadn_run = dsp_biquadn_run_sse,
 		.funcs.sum = dsp_sum_sse,
 		.funcs.fft_new = dsp_fft_new_c,
 		.funcs.fft_free = dsp_fft_free_c,
@@ -53,6 +55,7 @@ static struct dsp_info dsp_table[] =
 		.funcs.copy = dsp_copy_c,
 		.funcs.mix_gain = dsp_mix_gain_c,
 		.funcs.biquad_run = dsp_biquad_run_c,
+		.funcs.biquadn_run = dsp_biquadn_run_c,
 		.funcs.sum = dsp_sum_c,
 		.funcs.fft_new = dsp_fft_new_c,
 		.funcs.fft_free = dsp_fft_free_c,
@@ -13,6 +13,7 @@
 #include <pipewire/log.h>
 #include <pipewire/utils.h>
 #include <pipewire/array.h>
+#include <pipewire/thread-loop.h>
 
 #include <lilv/lilv.h>
 
@@ -91,6 +92,9 @@ struct context {
 	struct spa_loop *data_loop;
 	struct spa_loop *main_loop;
 
+	/* runs the non-RT work of the plugins */
+	struct pw_thread_loop *work_loop;
+
 	LilvNode *lv2_InputPort;
 	LilvNode *lv2_OutputPort;
 	LilvNode *lv2_AudioPort;
@@ -119,6 +123,10 @@ struct context {
 
 static void context_free(struct context *c)
 {
+	if (c->work_loop) {
+		pw_thread_loop_stop(c->work_loop);
+		pw_thread_loop_destroy(c->work_loop);
+	}
 	if (c->world) {
 		lilv_node_free(c->worker_schedule);
 		lilv_node_free(c->powerOf2BlockLength);
@@ -205,6 +213,21 @@ static struct context *context_ref(const struct spa_support *support, uint32_t n
 	return _context;
 }
 
+static struct spa_loop *context_get_work_loop(struct context *c)
+{
+	if (c->work_loop == NULL) {
+		c->work_loop = pw_thread_loop_new("filter-chain-lv2-worker", NULL);
+		if (c->work_loop == NULL || pw_thread_loop_start(c->work_loop) < 0) {
+			pw_log_warn("can't start LV2 worker thread, using the main loop: %m");
+			if (c->work_loop)
+				pw_thread_loop_destroy(c->work_loop);
+			c->work_loop = NULL;
+			return c->main_loop;
+		}
+	}
+	return pw_thread_loop_get_loop(c->work_loop)->loop;
+}
+
 static void context_unref(struct context *context)
 {
 	if (--_context->ref == 0) {
@@ -235,6 +258,7 @@ struct instance {
 	const LV2_Feature *features[7];
 
 	const LV2_Worker_Interface *work_iface;
+	struct spa_loop *work_loop;
 
 	int32_t block_length;
 };
@@ -272,8 +296,8 @@ static LV2_Worker_Status
 work_schedule(LV2_Worker_Schedule_Handle handle, uint32_t size, const void *data)
 {
 	struct instance *i = (struct instance*)handle;
-	struct context *c = i->desc->p->c;
-	spa_loop_invoke(c->main_loop, do_schedule, 1, data, size, false, i);
+	if (spa_loop_invoke(i->work_loop, do_schedule, 1, data, size, false, i) < 0)
+		return LV2_WORKER_ERR_NO_SPACE;
 	return LV2_WORKER_SUCCESS;
 }
 
@@ -302,6 +326,7 @@ static void *lv2_instantiate(const struct fc_descriptor *desc,
 	i->features[n_features++] = &buf_size_features[1];
 	i->features[n_features++] = &buf_size_features[2];
 	if (lilv_plugin_has_feature(p->p, c->worker_schedule)) {
+		i->work_loop = context_get_work_loop(c);
 		i->work_schedule.handle = i;
 		i->work_schedule.schedule_work = work_schedule;
 		i->work_schedule_feature.URI = LV2_WORKER__schedule;
@@ -346,6 +371,9 @@ static void *lv2_instantiate(const struct fc_descriptor *desc,
 static void lv2_cleanup(void *instance)
 {
 	struct instance *i = instance;
+	/* wait for the work that is still queued for this instance */
+	if (i->work_loop)
+		spa_loop_invoke(i->work_loop, NULL, 0, NULL, 0, true, NULL);
 	lilv_instance_free(i->instance);
 	free(i);
 }
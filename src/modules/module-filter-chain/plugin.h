@@ -63,6 +63,11 @@ struct fc_descriptor {
 	void (*deactivate) (void *instance);
 
 	void (*run) (void *instance, unsigned long SampleCount);
+	/* run n_instances chains of n_sections instances, instances[s * n_instances + i]
+	 * is section s of chain i. Sections after the first take their input from the
+	 * output of the previous section, the ports in between are not used. */
+	void (*run_multi) (void **instances, uint32_t n_instances, uint32_t n_sections,
+			unsigned long SampleCount);
 };
 
 static inline void fc_plugin_free(struct fc_plugin *plugin)
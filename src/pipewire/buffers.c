@@ -24,8 +24,92 @@ struct port {
 	uint32_t port_id;
 };
 
+/* shared buffer memory, kept in the context cache when the buffers are
+ * cleared so that a renegotiation with the same layout can reuse the
+ * memory that is already mapped and faulted in. Memory that was given to
+ * remote nodes is only reused between the same nodes. */
+struct buffer_mem {
+	struct spa_list link;
+	struct pw_context *context;
+	struct pw_memrange *range;
+	struct spa_node *owner[2];
+};
+
+static void buffer_mem_free(struct buffer_mem *m)
+{
+	pw_memrange_free(m->range);
+	free(m);
+}
+
+static struct buffer_mem *buffer_mem_take(struct pw_context *context, size_t size,
+		struct spa_node *owner[2])
+{
+	struct buffer_mem *m;
+
+	spa_list_for_each(m, &context->buffer_cache, link) {
+		if (m->range->size != size ||
+		    m->owner[0] != owner[0] || m->owner[1] != owner[1])
+			continue;
+		spa_list_remove(&m->link);
+		context->buffer_cache_size -= m->range->size;
+		pw_log_debug("%p: reuse cached memory %p size:%zd", context, m, size);
+		return m;
+	}
+	return NULL;
+}
+
+static void buffer_mem_release(struct buffer_mem *m)
+{
+	struct pw_context *context = m->context;
+
+	if (m->range->size > context->max_buffer_cache) {
+		buffer_mem_free(m);
+		return;
+	}
+	/* keep the cache below the max bytes, drop the oldest memory first */
+	while (context->buffer_cache_size + m->range->size > context->max_buffer_cache) {
+		struct buffer_mem *old;
+		old = spa_list_last(&context->buffer_cache, struct buffer_mem, link);
+		spa_list_remove(&old->link);
+		context->buffer_cache_size -= old->range->size;
+		buffer_mem_free(old);
+	}
+	pw_log_debug("%p: cache memory %p size:%u", context, m, m->range->size);
+	spa_list_prepend(&context->buffer_cache, &m->link);
+	context->buffer_cache_size += m->range->size;
+}
+
+void pw_buffers_cache_flush(struct pw_context *context, struct spa_node *node)
+{
+	struct buffer_mem *m, *t;
+
+	spa_list_for_each_safe(m, t, &context->buffer_cache, link) {
+		if (node != NULL && m->owner[0] != node && m->owner[1] != node)
+			continue;
+		spa_list_remove(&m->link);
+		context->buffer_cache_size -= m->range->size;
+		buffer_mem_free(m);
+	}
+}
+
+/* the metadata and chunks are not in the skeleton, clear them when
+ * the memory is reused so that buffers start like freshly allocated ones */
+static void clear_buffers(struct spa_buffer **buffers, uint32_t n_buffers)
+{
+	uint32_t i, j;
+
+	for (i = 0; i < n_buffers; i++) {
+		struct spa_buffer *b = buffers[i];
+		for (j = 0; j < b->n_metas; j++)
+			memset(b->metas[j].data, 0, b->metas[j].size);
+		for (j = 0; j < b->n_datas; j++)
+			spa_zero(*b->datas[j].chunk);
+	}
+}
+
 /* Allocate an array of buffers that can be shared */
-static int alloc_buffers(struct pw_mempool *pool,
+static int alloc_buffers(struct pw_context *context,
+			 struct spa_node *owner[2],
 			 uint32_t n_buffers,
 			 uint32_t n_params,
 			 struct spa_pod **params,
@@ -43,7 +127,8 @@ static int alloc_buffers(struct pw_mempool *pool,
 	uint32_t n_metas;
 	struct spa_meta *metas;
 	struct spa_data *datas;
-	struct pw_memblock *m;
+	struct buffer_mem *m = NULL;
+	bool reused = false;
 	struct spa_buffer_alloc_info info = { 0, };
 
 	if (!SPA_FLAG_IS_SET(flags, PW_BUFFERS_FLAG_SHARED))
@@ -102,29 +187,44 @@ static int alloc_buffers(struct pw_mempool *pool,
 	skel = SPA_PTR_ALIGN(skel, info.max_align, void);
 
 	if (SPA_FLAG_IS_SET(flags, PW_BUFFERS_FLAG_SHARED)) {
+		size_t size = n_buffers * info.mem_size;
+
 		/* pointer to buffer structures */
-		m = pw_mempool_alloc(pool,
-				PW_MEMBLOCK_FLAG_READWRITE |
-				PW_MEMBLOCK_FLAG_SEAL |
-				PW_MEMBLOCK_FLAG_MAP,
-				SPA_DATA_MemFd,
-				n_buffers * info.mem_size);
-		if (m == NULL) {
-			free(buffers);
-			return -errno;
+		m = buffer_mem_take(context, size, owner);
+		if (m != NULL) {
+			reused = true;
+		} else {
+			if ((m = calloc(1, sizeof(*m))) == NULL) {
+				free(buffers);
+				return -errno;
+			}
+			m->range = pw_mempool_alloc_range(context->pool,
+					PW_MEMBLOCK_FLAG_READWRITE |
+					PW_MEMBLOCK_FLAG_SEAL |
+					PW_MEMBLOCK_FLAG_MAP,
+					SPA_DATA_MemFd, size);
+			if (m->range == NULL) {
+				free(m);
+				free(buffers);
+				return -errno;
+			}
+			m->context = context;
+			m->owner[0] = owner[0];
+			m->owner[1] = owner[1];
 		}
-
-		data = m->map->ptr;
+		data = m->range->ptr;
 	} else {
-		m = NULL;
 		data = NULL;
 	}
 
-	pw_log_debug("%p: layout buffers skel:%p data:%p buffers:%p",
-			allocation, skel, data, buffers);
+	pw_log_debug("%p: layout buffers skel:%p data:%p buffers:%p reused:%d",
+			allocation, skel, data, buffers, reused);
 	spa_buffer_alloc_layout_array(&info, n_buffers, buffers, skel, data);
+	if (reused)
+		clear_buffers(buffers, n_buffers);
 
-	allocation->mem = m;
+	allocation->mem = m ? m->range->block : NULL;
+	allocation->priv = m;
 	allocation->n_buffers = n_buffers;
 	allocation->buffers = buffers;
 	allocation->flags = flags;
@@ -229,6 +329,7 @@ int pw_buffers_negotiate(struct pw_context *context, uint32_t flags,
 	uint32_t types, *data_types;
 	struct port output = { outnode, SPA_DIRECTION_OUTPUT, out_port_id };
 	struct port input = { innode, SPA_DIRECTION_INPUT, in_port_id };
+	struct spa_node *owner[2] = { NULL, NULL };
 	int res;
 
 	if (flags & PW_BUFFERS_FLAG_IN_PRIORITY) {
@@ -326,7 +427,15 @@ int pw_buffers_negotiate(struct pw_context *context, uint32_t flags,
 		data_types[i] = types;
 	}
 
-	if ((res = alloc_buffers(context->pool,
+	/* memory for remote nodes can only be reused between the same nodes,
+	 * the clients might still have the old memory mapped */
+	if (SPA_FLAG_IS_SET(flags, PW_BUFFERS_FLAG_SHARED_MEM)) {
+		owner[0] = outnode;
+		owner[1] = innode;
+	}
+
+	if ((res = alloc_buffers(context,
+				 owner,
 				 max_buffers,
 				 n_params,
 				 params,
@@ -345,8 +454,8 @@ SPA_EXPORT
 void pw_buffers_clear(struct pw_buffers *buffers)
 {
 	pw_log_debug("%p: clear %d buffers:%p", buffers, buffers->n_buffers, buffers->buffers);
-	if (buffers->mem)
-		pw_memblock_unref(buffers->mem);
+	if (buffers->priv)
+		buffer_mem_release(buffers->priv);
 	free(buffers->buffers);
 	spa_zero(*buffers);
 }
@@ -36,6 +36,7 @@ struct pw_buffers {
 	struct spa_buffer **buffers;	/**< port buffers */
 	uint32_t n_buffers;		/**< number of port buffers */
 	uint32_t flags;			/**< flags */
+	void *priv;			/**< private allocation data */
 };
 
 int pw_buffers_negotiate(struct pw_context *context, uint32_t flags,
@@ -378,12 +378,70 @@ int pw_conf_save_state(const char *prefix, const char *name, const struct pw_pro
 	return 0;
 }
 
-static int conf_load(const char *path, struct pw_properties *conf)
+/* a config file that was used, for checking if the cache is still valid */
+struct conf_cache_file {
+	uint64_t dev;
+	uint64_t ino;
+	uint64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	int64_t ctime_sec;
+	int64_t ctime_nsec;
+	uint32_t path_len;		/**< including the 0 byte */
+	uint32_t padding;
+	/* followed by path, padded to 8 bytes */
+};
+
+struct conf_file {
+	struct conf_cache_file info;
+	char *path;
+};
+
+static int conf_add_file(struct pw_array *files, const char *path, const struct stat *st)
+{
+	struct conf_file *f;
+
+	if ((f = pw_array_add(files, sizeof(*f))) == NULL)
+		return -errno;
+	spa_zero(*f);
+	f->info.dev = st->st_dev;
+	f->info.ino = st->st_ino;
+	f->info.size = st->st_size;
+	f->info.mtime_sec = st->st_mtim.tv_sec;
+	f->info.mtime_nsec = st->st_mtim.tv_nsec;
+	f->info.ctime_sec = st->st_ctim.tv_sec;
+	f->info.ctime_nsec = st->st_ctim.tv_nsec;
+	f->info.path_len = strlen(path) + 1;
+	if ((f->path = strdup(path)) == NULL) {
+		files->size -= sizeof(*f);
+		return -errno;
+	}
+	return 0;
+}
+
+static void conf_clear_files(struct pw_array *files)
+{
+	struct conf_file *f;
+	pw_array_for_each(f, files)
+		free(f->path);
+	pw_array_reset(files);
+}
+
+/* when parse is false, only check and record the file */
+static int conf_load(const char *path, struct pw_properties *conf,
+		struct pw_array *files, bool parse)
 {
 	char *data;
 	struct stat sbuf;
 	int count;
 
+	if (!parse) {
+		if (stat(path, &sbuf) < 0 ||
+		    (files != NULL && conf_add_file(files, path, &sbuf) < 0))
+			return -errno;
+		return 0;
+	}
+
 	spa_autoclose int fd = open(path,  O_CLOEXEC | O_RDONLY);
 	if (fd < 0)
 		goto error;
@@ -391,6 +449,9 @@ static int conf_load(const char *path, struct pw_properties *conf)
 	if (fstat(fd, &sbuf) < 0)
 		goto error;
 
+	if (files != NULL && conf_add_file(files, path, &sbuf) < 0)
+		goto error;
+
 	if (sbuf.st_size > 0) {
 		if ((data = mmap(NULL, sbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
 			goto error;
@@ -448,8 +509,8 @@ static int conf_filter(const struct dirent *entry)
 	return spa_strendswith(entry->d_name, ".conf");
 }
 
-SPA_EXPORT
-int pw_conf_load_conf(const char *prefix, const char *name, struct pw_properties *conf)
+static int load_conf(const char *prefix, const char *name, struct pw_properties *conf,
+		struct pw_array *files, bool parse)
 {
 	char path[PATH_MAX];
 	char fname[PATH_MAX + 256];
@@ -470,7 +531,7 @@ int pw_conf_load_conf(const char *prefix, const char *name, struct pw_properties
 	pw_properties_set(conf, "config.name", name);
 	pw_properties_set(conf, "config.path", path);
 
-	if ((res = conf_load(path, conf)) < 0)
+	if ((res = conf_load(path, conf, files, parse)) < 0)
 		return res;
 
 	pw_properties_setf(conf, "config.name.d", "%s.d", name);
@@ -499,7 +560,7 @@ int pw_conf_load_conf(const char *prefix, const char *name, struct pw_properties
 
 			snprintf(fname, sizeof(fname), "%s/%s", path, name);
 			if (check_override(conf, name, level)) {
-				if (conf_load(fname, override) >= 0)
+				if (conf_load(fname, override, files, parse) >= 0)
 					add_override(conf, override, fname, name, level, i);
 				pw_properties_clear(override);
 			} else {
@@ -513,6 +574,276 @@ int pw_conf_load_conf(const char *prefix, const char *name, struct pw_properties
 	return 0;
 }
 
+/*
+ * The config cache stores the loaded config properties together with the
+ * files that were used to make them. It is used when the same files with
+ * the same modification times would be loaded again.
+ */
+#define CONF_CACHE_MAGIC	0x43435750	/* PWCC */
+#define CONF_CACHE_VERSION	1
+
+struct conf_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t n_files;
+	uint32_t n_items;
+	uint64_t size;			/**< total size of the cache file */
+	/* followed by n_files conf_cache_file, then n_items conf_cache_item */
+};
+
+struct conf_cache_item {
+	uint32_t key_len;		/**< including the 0 byte */
+	uint32_t value_len;		/**< including the 0 byte */
+	/* followed by key and value, padded to 8 bytes */
+};
+
+#define CONF_CACHE_PAD(s)	SPA_ROUND_UP_N((uint64_t)(s), 8)
+
+static int get_cache_path(char *path, size_t size, const char *prefix, const char *name,
+		bool create)
+{
+	const char *dir, *file;
+	char buffer[4096], cname[64];
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	int len, res = -ENOENT;
+
+	/* FNV-1a of prefix and name */
+	for (file = prefix ? prefix : ""; *file; file++)
+		hash = (hash ^ (uint8_t)*file) * 0x100000001b3ULL;
+	hash = hash * 0x100000001b3ULL;
+	for (file = name; *file; file++)
+		hash = (hash ^ (uint8_t)*file) * 0x100000001b3ULL;
+	snprintf(cname, sizeof(cname), "conf-%016"PRIx64".cache", hash);
+
+	dir = getenv("XDG_CACHE_HOME");
+	if (dir != NULL) {
+		const char *paths[] = { dir, "pipewire", NULL };
+		res = create ? ensure_path(path, size, paths) : make_path(path, size, paths);
+	}
+	if (res < 0) {
+		dir = getenv("HOME");
+		if (dir == NULL) {
+			struct passwd pwd, *result = NULL;
+			if (getpwuid_r(getuid(), &pwd, buffer, sizeof(buffer), &result) == 0)
+				dir = result ? result->pw_dir : NULL;
+		}
+		if (dir != NULL) {
+			const char *paths[] = { dir, ".cache", "pipewire", NULL };
+			res = create ? ensure_path(path, size, paths) : make_path(path, size, paths);
+		}
+	}
+	if (res < 0)
+		return res;
+
+	len = strlen(path);
+	res = snprintf(path + len, size - len, "%s%s",
+			len > 0 && path[len-1] == '/' ? "" : "/", cname);
+	if (res < 0 || (size_t)res >= size - len)
+		return -ENOSPC;
+	return 0;
+}
+
+static int conf_cache_load(const char *path, struct pw_array *files,
+		struct pw_properties *conf)
+{
+	const struct conf_cache_header *h;
+	struct conf_file *f;
+	struct stat sbuf;
+	const uint8_t *data, *p, *q, *end;
+	uint32_t i, n_items;
+	int res = -ESTALE;
+
+	spa_autoclose int fd = open(path, O_CLOEXEC | O_RDONLY);
+	if (fd < 0)
+		return -errno;
+	if (fstat(fd, &sbuf) < 0)
+		return -errno;
+	if ((size_t)sbuf.st_size < sizeof(*h))
+		return -EINVAL;
+	if ((data = mmap(NULL, sbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+		return -errno;
+
+	h = (const struct conf_cache_header *)data;
+	p = data + sizeof(*h);
+	end = data + sbuf.st_size;
+
+	if (h->magic != CONF_CACHE_MAGIC || h->version != CONF_CACHE_VERSION ||
+	    h->size != (uint64_t)sbuf.st_size ||
+	    h->n_files != pw_array_get_len(files, struct conf_file))
+		goto done;
+
+	/* all files must be the same as the ones we would load now */
+	pw_array_for_each(f, files) {
+		const struct conf_cache_file *cf = (const struct conf_cache_file *)p;
+		const char *cpath = (const char *)(cf + 1);
+
+		if ((size_t)(end - p) < sizeof(*cf) ||
+		    cf->path_len != f->info.path_len ||
+		    (uint64_t)(end - (const uint8_t *)cpath) < CONF_CACHE_PAD(cf->path_len) ||
+		    cf->dev != f->info.dev || cf->ino != f->info.ino ||
+		    cf->size != f->info.size ||
+		    cf->mtime_sec != f->info.mtime_sec ||
+		    cf->mtime_nsec != f->info.mtime_nsec ||
+		    cf->ctime_sec != f->info.ctime_sec ||
+		    cf->ctime_nsec != f->info.ctime_nsec ||
+		    memcmp(cpath, f->path, cf->path_len) != 0)
+			goto done;
+		p = (const uint8_t *)cpath + CONF_CACHE_PAD(cf->path_len);
+	}
+
+	/* check the items before adding them */
+	n_items = h->n_items;
+	for (i = 0, q = p; i < n_items; i++) {
+		const struct conf_cache_item *ci = (const struct conf_cache_item *)q;
+		const char *key = (const char *)(ci + 1);
+		uint64_t len;
+
+		if ((size_t)(end - q) < sizeof(*ci) ||
+		    ci->key_len == 0 || ci->value_len == 0) {
+			res = -EINVAL;
+			goto done;
+		}
+		len = CONF_CACHE_PAD(ci->key_len) + CONF_CACHE_PAD(ci->value_len);
+		if ((uint64_t)(end - (const uint8_t *)key) < len ||
+		    key[ci->key_len - 1] != '\0' ||
+		    key[CONF_CACHE_PAD(ci->key_len) + ci->value_len - 1] != '\0') {
+			res = -EINVAL;
+			goto done;
+		}
+		q = (const uint8_t *)key + len;
+	}
+	for (i = 0; i < n_items; i++) {
+		const struct conf_cache_item *ci = (const struct conf_cache_item *)p;
+		const char *key = (const char *)(ci + 1);
+
+		pw_properties_set(conf, key, key + CONF_CACHE_PAD(ci->key_len));
+		p = (const uint8_t *)key + CONF_CACHE_PAD(ci->key_len) +
+			CONF_CACHE_PAD(ci->value_len);
+	}
+	res = 0;
+done:
+	munmap((void *)data, sbuf.st_size);
+	return res;
+}
+
+static int write_padded(FILE *f, const void *data, size_t size)
+{
+	static const uint8_t zero[8];
+	if (fwrite(data, 1, size, f) != size ||
+	    fwrite(zero, 1, CONF_CACHE_PAD(size) - size, f) != CONF_CACHE_PAD(size) - size)
+		return -EIO;
+	return 0;
+}
+
+static int conf_cache_save(const char *path, struct pw_array *files,
+		const struct pw_properties *conf)
+{
+	struct conf_cache_header h;
+	const struct spa_dict_item *it;
+	struct conf_file *f;
+	char *tmp_name;
+	FILE *file;
+	int fd, res = 0;
+
+	tmp_name = alloca(strlen(path) + 8);
+	sprintf(tmp_name, "%s.XXXXXX", path);
+	if ((fd = mkostemp(tmp_name, O_CLOEXEC)) < 0)
+		return -errno;
+	if ((file = fdopen(fd, "w")) == NULL) {
+		res = -errno;
+		close(fd);
+		goto error;
+	}
+
+	spa_zero(h);
+	h.magic = CONF_CACHE_MAGIC;
+	h.version = CONF_CACHE_VERSION;
+	h.n_files = pw_array_get_len(files, struct conf_file);
+	h.n_items = conf->dict.n_items;
+	if ((res = write_padded(file, &h, sizeof(h))) < 0)
+		goto error_close;
+
+	pw_array_for_each(f, files) {
+		if ((res = write_padded(file, &f->info, sizeof(f->info))) < 0 ||
+		    (res = write_padded(file, f->path, f->info.path_len)) < 0)
+			goto error_close;
+	}
+	spa_dict_for_each(it, &conf->dict) {
+		struct conf_cache_item ci;
+		ci.key_len = strlen(it->key) + 1;
+		ci.value_len = strlen(it->value ? it->value : "") + 1;
+		if ((res = write_padded(file, &ci, sizeof(ci))) < 0 ||
+		    (res = write_padded(file, it->key, ci.key_len)) < 0 ||
+		    (res = write_padded(file, it->value ? it->value : "", ci.value_len)) < 0)
+			goto error_close;
+	}
+	h.size = ftell(file);
+	if (fseek(file, 0, SEEK_SET) < 0 ||
+	    (res = write_padded(file, &h, sizeof(h))) < 0)
+		goto error_close;
+	if (fclose(file) != 0) {
+		res = -errno;
+		goto error;
+	}
+	if (rename(tmp_name, path) < 0) {
+		res = -errno;
+		goto error;
+	}
+	pw_log_info("saved config cache '%s'", path);
+	return 0;
+
+error_close:
+	fclose(file);
+error:
+	pw_log_warn("can't save config cache '%s': %s", path, spa_strerror(res));
+	unlink(tmp_name);
+	return res;
+}
+
+SPA_EXPORT
+int pw_conf_load_conf(const char *prefix, const char *name, struct pw_properties *conf)
+{
+	struct pw_array files;
+	char path[PATH_MAX];
+	int res;
+
+	if (name == NULL || conf->dict.n_items > 0 ||
+	    !pw_check_option("config-cache", "true") ||
+	    get_cache_path(path, sizeof(path), prefix, name, false) < 0)
+		return load_conf(prefix, name, conf, NULL, true);
+
+	pw_array_init(&files, 16 * sizeof(struct conf_file));
+
+	/* find the files we would load now and compare with the cache */
+	{
+		spa_autoptr(pw_properties) check = pw_properties_new(NULL, NULL);
+		if (check == NULL) {
+			res = -errno;
+			goto done;
+		}
+		if ((res = load_conf(prefix, name, check, &files, false)) < 0)
+			goto done;
+	}
+	if ((res = conf_cache_load(path, &files, conf)) == 0) {
+		pw_log_info("%p: loaded config '%s' from cache '%s' with %u items",
+				conf, name, path, conf->dict.n_items);
+		goto done;
+	}
+	pw_log_debug("%p: can't use config cache '%s': %s", conf, path,
+			spa_strerror(res));
+
+	conf_clear_files(&files);
+	if ((res = load_conf(prefix, name, conf, &files, true)) < 0)
+		goto done;
+
+	if (get_cache_path(path, sizeof(path), prefix, name, true) == 0)
+		conf_cache_save(path, &files, conf);
+done:
+	conf_clear_files(&files);
+	pw_array_clear(&files);
+	return res;
+}
+
 SPA_EXPORT
 int pw_conf_load_state(const char *prefix, const char *name, struct pw_properties *conf)
 {
@@ -527,7 +858,7 @@ int pw_conf_load_state(const char *prefix, const char *name, struct pw_propertie
 		pw_log_debug("%p: can't load config '%s': %m", conf, path);
 		return -ENOENT;
 	}
-	return conf_load(path, conf);
+	return conf_load(path, conf, NULL, true);
 }
 
 struct data {
@@ -583,6 +914,112 @@ static int load_module(struct pw_context *context, const char *key, const char *
 	return 0;
 }
 
+/*
+ * Match rules are compiled into flat arrays so that they can be
+ * evaluated without parsing the JSON again.
+ */
+struct rule_key {
+	char *key;
+	const char *value;		/**< cached lookup result, valid until an action ran */
+	uint32_t serial;		/**< match serial of the cached value */
+};
+
+struct rule_pred {
+	uint32_t key;			/**< index in keys */
+	char *value;			/**< NULL for null */
+	int regex;			/**< 0 not compiled, 1 compiled, -1 invalid */
+	regex_t preg;
+};
+
+struct rule_match {
+	uint32_t first_pred;
+	uint32_t n_preds;
+};
+
+struct rule_action {
+	char *action;
+	char *value;
+	size_t len;
+};
+
+struct rule {
+	uint32_t first_match;
+	uint32_t n_matches;
+	uint32_t first_action;
+	uint32_t n_actions;
+};
+
+struct match_rules {
+	struct pw_array keys;
+	struct pw_array preds;
+	struct pw_array matches;
+	struct pw_array actions;
+	struct pw_array rules;
+	uint32_t serial;
+};
+
+static struct match_rules *match_rules_new(void)
+{
+	struct match_rules *r;
+
+	r = calloc(1, sizeof(*r));
+	if (r == NULL)
+		return NULL;
+
+	pw_array_init(&r->keys, 16 * sizeof(struct rule_key));
+	pw_array_init(&r->preds, 16 * sizeof(struct rule_pred));
+	pw_array_init(&r->matches, 16 * sizeof(struct rule_match));
+	pw_array_init(&r->actions, 16 * sizeof(struct rule_action));
+	pw_array_init(&r->rules, 16 * sizeof(struct rule));
+	return r;
+}
+
+static void match_rules_free(struct match_rules *r)
+{
+	struct rule_key *k;
+	struct rule_pred *p;
+	struct rule_action *a;
+
+	pw_array_for_each(k, &r->keys)
+		free(k->key);
+	pw_array_for_each(p, &r->preds) {
+		if (p->regex == 1)
+			regfree(&p->preg);
+		free(p->value);
+	}
+	pw_array_for_each(a, &r->actions) {
+		free(a->action);
+		free(a->value);
+	}
+	pw_array_clear(&r->keys);
+	pw_array_clear(&r->preds);
+	pw_array_clear(&r->matches);
+	pw_array_clear(&r->actions);
+	pw_array_clear(&r->rules);
+	free(r);
+}
+
+static int match_rules_add_key(struct match_rules *r, const char *key)
+{
+	struct rule_key *k;
+	uint32_t idx = 0;
+
+	pw_array_for_each(k, &r->keys) {
+		if (spa_streq(k->key, key))
+			return idx;
+		idx++;
+	}
+	if ((k = pw_array_add(&r->keys, sizeof(*k))) == NULL)
+		return -errno;
+	if ((k->key = strdup(key)) == NULL) {
+		r->keys.size -= sizeof(*k);
+		return -errno;
+	}
+	k->value = NULL;
+	k->serial = 0;
+	return idx;
+}
+
 /*
  * {
  *     # all keys must match the value. ~ in value starts regex.
@@ -590,60 +1027,131 @@ static int load_module(struct pw_context *context, const char *key, const char *
  *     ...
  * }
  */
-static bool find_match(struct spa_json *arr, const struct spa_dict *props)
+static int match_rules_add_matches(struct match_rules *r, struct spa_json *arr,
+		uint32_t *first_match, uint32_t *n_matches)
 {
 	struct spa_json it[1];
 
+	*first_match = pw_array_get_len(&r->matches, struct rule_match);
+	*n_matches = 0;
+
 	while (spa_json_enter_object(arr, &it[0]) > 0) {
 		char key[256], val[1024];
-		const char *str, *value;
-		int match = 0, fail = 0;
-		int len;
+		const char *value;
+		struct rule_match *m;
+		struct rule_pred *p;
+		uint32_t first_pred, n_preds = 0;
+		int len, k;
+
+		first_pred = pw_array_get_len(&r->preds, struct rule_pred);
 
 		while (spa_json_get_string(&it[0], key, sizeof(key)) > 0) {
-			bool success = false;
+			char *v = NULL;
 
 			if ((len = spa_json_next(&it[0], &value)) <= 0)
 				break;
 
-			str = spa_dict_lookup(props, key);
-
-			if (spa_json_is_null(value, len)) {
-				success = str == NULL;
-			} else {
+			if (!spa_json_is_null(value, len)) {
 				if (spa_json_parse_stringn(value, len, val, sizeof(val)) < 0)
 					continue;
-				value = val;
-				len = strlen(val);
-			}
-			if (str != NULL) {
-				if (value[0] == '~') {
-					regex_t preg;
-					if (regcomp(&preg, value+1, REG_EXTENDED | REG_NOSUB) == 0) {
-						if (regexec(&preg, str, 0, NULL, 0) == 0)
-							success = true;
-						regfree(&preg);
-					}
-				} else if (strncmp(str, value, len) == 0 &&
-				    strlen(str) == (size_t)len) {
-					success = true;
-				}
+				if ((v = strdup(val)) == NULL)
+					return -errno;
 			}
-			if (success) {
-				match++;
-				pw_log_debug("'%s' match '%s' < > '%.*s'", key, str, len, value);
+			if ((k = match_rules_add_key(r, key)) < 0 ||
+			    (p = pw_array_add(&r->preds, sizeof(*p))) == NULL) {
+				free(v);
+				return k < 0 ? k : -errno;
 			}
-			else {
-				fail++;
+			spa_zero(*p);
+			p->key = k;
+			p->value = v;
+			n_preds++;
+		}
+		if ((m = pw_array_add(&r->matches, sizeof(*m))) == NULL)
+			return -errno;
+		m->first_pred = first_pred;
+		m->n_preds = n_preds;
+		(*n_matches)++;
+	}
+	return 0;
+}
+
+/* get a new serial for evaluating the rules against new props */
+static uint32_t match_rules_serial(struct match_rules *r)
+{
+	if (++r->serial == 0)
+		r->serial++;
+	return r->serial;
+}
+
+static bool match_pred(struct match_rules *r, struct rule_pred *p,
+		const struct spa_dict *props, uint32_t serial)
+{
+	struct rule_key *k = pw_array_get_unchecked(&r->keys, p->key, struct rule_key);
+	const char *str;
+
+	if (k->serial != serial) {
+		k->value = spa_dict_lookup(props, k->key);
+		k->serial = serial;
+	}
+	str = k->value;
+
+	/* an unquoted null also matches the string "null" */
+	if (p->value == NULL)
+		return str == NULL || spa_streq(str, "null");
+	if (str == NULL)
+		return false;
+
+	if (p->value[0] == '~') {
+		if (p->regex == 0)
+			p->regex = regcomp(&p->preg, p->value + 1,
+					REG_EXTENDED | REG_NOSUB) == 0 ? 1 : -1;
+		return p->regex == 1 && regexec(&p->preg, str, 0, NULL, 0) == 0;
+	}
+	return spa_streq(str, p->value);
+}
+
+static bool match_rules_find(struct match_rules *r, uint32_t first_match,
+		uint32_t n_matches, const struct spa_dict *props, uint32_t serial)
+{
+	uint32_t i, j;
+
+	for (i = 0; i < n_matches; i++) {
+		struct rule_match *m = pw_array_get_unchecked(&r->matches,
+				first_match + i, struct rule_match);
+
+		for (j = 0; j < m->n_preds; j++) {
+			struct rule_pred *p = pw_array_get_unchecked(&r->preds,
+					m->first_pred + j, struct rule_pred);
+			struct rule_key *k = pw_array_get_unchecked(&r->keys,
+					p->key, struct rule_key);
+
+			if (!match_pred(r, p, props, serial))
 				break;
-			}
+			pw_log_debug("'%s' match '%s' < > '%s'", k->key, k->value,
+					p->value ? p->value : "null");
 		}
-		if (match > 0 && fail == 0)
+		if (m->n_preds > 0 && j == m->n_preds)
 			return true;
 	}
 	return false;
 }
 
+static bool find_match(struct spa_json *arr, const struct spa_dict *props)
+{
+	struct match_rules *r;
+	uint32_t first_match, n_matches;
+	bool res = false;
+
+	if ((r = match_rules_new()) == NULL)
+		return false;
+	if (match_rules_add_matches(r, arr, &first_match, &n_matches) >= 0)
+		res = match_rules_find(r, first_match, n_matches, props,
+				match_rules_serial(r));
+	match_rules_free(r);
+	return res;
+}
+
 /*
  * context.modules = [
  *   {   name = <module-name>
@@ -1068,50 +1576,35 @@ int pw_conf_load_conf_for_context(struct pw_properties *props, struct pw_propert
 	return res;
 }
 
-/**
- * [
- *     {
- *         matches = [
- *             # any of the items in matches needs to match, if one does,
- *             # actions are emited.
- *             {
- *                 # all keys must match the value. ~ in value starts regex.
- *                 <key> = <value>
- *                 ...
- *             }
- *             ...
- *         ]
- *         actions = {
- *             <action> = <value>
- *             ...
- *         }
- *     }
- * ]
- */
-SPA_EXPORT
-int pw_conf_match_rules(const char *str, size_t len, const char *location,
-		const struct spa_dict *props,
-		int (*callback) (void *data, const char *location, const char *action,
-			const char *str, size_t len),
-		void *data)
+static struct match_rules *match_rules_parse(const char *str, size_t len)
 {
+	struct match_rules *r;
 	const char *val;
 	struct spa_json it[4], actions;
+	int res = 0;
+
+	if ((r = match_rules_new()) == NULL)
+		return NULL;
 
 	spa_json_init(&it[0], str, len);
 	if (spa_json_enter_array(&it[0], &it[1]) < 0)
-		return 0;
+		return r;
 
 	while (spa_json_enter_object(&it[1], &it[2]) > 0) {
 		char key[64];
 		bool have_match = false, have_actions = false;
+		struct rule *rule;
+		uint32_t first_match = 0, n_matches = 0, first_action, n_actions = 0;
 
 		while (spa_json_get_string(&it[2], key, sizeof(key)) > 0) {
 			if (spa_streq(key, "matches")) {
 				if (spa_json_enter_array(&it[2], &it[3]) < 0)
 					break;
 
-				have_match = find_match(&it[3], props);
+				if ((res = match_rules_add_matches(r, &it[3],
+						&first_match, &n_matches)) < 0)
+					goto error;
+				have_match = true;
 			}
 			else if (spa_streq(key, "actions")) {
 				if (spa_json_enter_object(&it[2], &actions) > 0)
@@ -1123,9 +1616,10 @@ int pw_conf_match_rules(const char *str, size_t len, const char *location,
 		if (!have_match || !have_actions)
 			continue;
 
+		first_action = pw_array_get_len(&r->actions, struct rule_action);
 		while (spa_json_get_string(&actions, key, sizeof(key)) > 0) {
-			int res, len;
-			pw_log_debug("action %s", key);
+			struct rule_action *a;
+			int len;
 
 			if ((len = spa_json_next(&actions, &val)) <= 0)
 				break;
@@ -1133,14 +1627,166 @@ int pw_conf_match_rules(const char *str, size_t len, const char *location,
 			if (spa_json_is_container(val, len))
 				len = spa_json_container_len(&actions, val, len);
 
-			if ((res = callback(data, location, key, val, len)) < 0)
+			if ((a = pw_array_add(&r->actions, sizeof(*a))) == NULL) {
+				res = -errno;
+				goto error;
+			}
+			a->action = strdup(key);
+			a->value = strndup(val, len);
+			a->len = len;
+			n_actions++;
+			if (a->action == NULL || a->value == NULL) {
+				res = -errno;
+				goto error;
+			}
+		}
+		if ((rule = pw_array_add(&r->rules, sizeof(*rule))) == NULL) {
+			res = -errno;
+			goto error;
+		}
+		rule->first_match = first_match;
+		rule->n_matches = n_matches;
+		rule->first_action = first_action;
+		rule->n_actions = n_actions;
+	}
+	return r;
+error:
+	match_rules_free(r);
+	errno = -res;
+	return NULL;
+}
+
+static int match_rules_emit(struct match_rules *r, const char *location,
+		const struct spa_dict *props,
+		int (*callback) (void *data, const char *location, const char *action,
+			const char *str, size_t len),
+		void *data)
+{
+	struct rule *rule;
+	uint32_t i, serial = match_rules_serial(r);
+	int res;
+
+	pw_array_for_each(rule, &r->rules) {
+		if (!match_rules_find(r, rule->first_match, rule->n_matches, props, serial))
+			continue;
+
+		for (i = 0; i < rule->n_actions; i++) {
+			struct rule_action *a = pw_array_get_unchecked(&r->actions,
+					rule->first_action + i, struct rule_action);
+
+			pw_log_debug("action %s", a->action);
+
+			if ((res = callback(data, location, a->action, a->value, a->len)) < 0)
 				return res;
 		}
+		/* the actions can change the props, look them up again */
+		if (rule->n_actions > 0)
+			serial = match_rules_serial(r);
 	}
 	return 0;
 }
 
+/**
+ * [
+ *     {
+ *         matches = [
+ *             # any of the items in matches needs to match, if one does,
+ *             # actions are emited.
+ *             {
+ *                 # all keys must match the value. ~ in value starts regex.
+ *                 <key> = <value>
+ *                 ...
+ *             }
+ *             ...
+ *         ]
+ *         actions = {
+ *             <action> = <value>
+ *             ...
+ *         }
+ *     }
+ * ]
+ */
+SPA_EXPORT
+int pw_conf_match_rules(const char *str, size_t len, const char *location,
+		const struct spa_dict *props,
+		int (*callback) (void *data, const char *location, const char *action,
+			const char *str, size_t len),
+		void *data)
+{
+	struct match_rules *r;
+	int res;
+
+	if ((r = match_rules_parse(str, len)) == NULL)
+		return -errno;
+	res = match_rules_emit(r, location, props, callback, data);
+	match_rules_free(r);
+	return res;
+}
+
+/* compiled rules of the context config sections, looked up by their text */
+struct rules_entry {
+	struct spa_list link;
+	char *str;
+	size_t len;
+	struct match_rules *rules;
+};
+
+#define MAX_RULES_CACHE	32
+
+static void rules_entry_free(struct rules_entry *e)
+{
+	spa_list_remove(&e->link);
+	match_rules_free(e->rules);
+	free(e->str);
+	free(e);
+}
+
+void pw_context_conf_rules_clear(struct pw_context *context)
+{
+	struct rules_entry *e;
+	spa_list_consume(e, &context->conf_rules, link)
+		rules_entry_free(e);
+	context->n_conf_rules = 0;
+}
+
+static struct match_rules *context_get_rules(struct pw_context *context,
+		const char *str, size_t len)
+{
+	struct rules_entry *e;
+
+	spa_list_for_each(e, &context->conf_rules, link) {
+		if (e->len == len && memcmp(e->str, str, len) == 0) {
+			spa_list_remove(&e->link);
+			spa_list_prepend(&context->conf_rules, &e->link);
+			return e->rules;
+		}
+	}
+	if ((e = calloc(1, sizeof(*e))) == NULL)
+		return NULL;
+	if ((e->str = malloc(len)) == NULL ||
+	    (e->rules = match_rules_parse(str, len)) == NULL) {
+		free(e->str);
+		free(e);
+		return NULL;
+	}
+	memcpy(e->str, str, len);
+	e->len = len;
+
+	if (context->n_conf_rules >= MAX_RULES_CACHE) {
+		rules_entry_free(spa_list_last(&context->conf_rules,
+					struct rules_entry, link));
+		context->n_conf_rules--;
+	}
+	spa_list_prepend(&context->conf_rules, &e->link);
+	context->n_conf_rules++;
+
+	pw_log_debug("%p: compiled %zd rules", context,
+			pw_array_get_len(&e->rules->rules, struct rule));
+	return e->rules;
+}
+
 struct match {
+	struct pw_context *context;
 	const struct spa_dict *props;
 	int (*matched) (void *data, const char *location, const char *action,
 			const char *val, size_t len);
@@ -1151,18 +1797,26 @@ static int match_rules(void *data, const char *location, const char *section,
 		const char *str, size_t len)
 {
 	struct match *match = data;
-	return pw_conf_match_rules(str, len, location,
-		match->props, match->matched, match->data);
+	struct match_rules *r;
+
+	if (match->context == NULL ||
+	    (r = context_get_rules(match->context, str, len)) == NULL)
+		return pw_conf_match_rules(str, len, location,
+			match->props, match->matched, match->data);
+
+	return match_rules_emit(r, location, match->props,
+			match->matched, match->data);
 }
 
-SPA_EXPORT
-int pw_conf_section_match_rules(const struct spa_dict *conf, const char *section,
+static int section_match_rules(struct pw_context *context,
+		const struct spa_dict *conf, const char *section,
 		const struct spa_dict *props,
 		int (*callback) (void *data, const char *location, const char *action,
 			const char *str, size_t len),
 		void *data)
 {
 	struct match match = {
+		.context = context,
 		.props = props,
 		.matched = callback,
 		.data = data };
@@ -1182,6 +1836,16 @@ int pw_conf_section_match_rules(const struct spa_dict *conf, const char *section
 	return res;
 }
 
+SPA_EXPORT
+int pw_conf_section_match_rules(const struct spa_dict *conf, const char *section,
+		const struct spa_dict *props,
+		int (*callback) (void *data, const char *location, const char *action,
+			const char *str, size_t len),
+		void *data)
+{
+	return section_match_rules(NULL, conf, section, props, callback, data);
+}
+
 SPA_EXPORT
 int pw_context_conf_update_props(struct pw_context *context,
 		const char *section, struct pw_properties *props)
@@ -1232,6 +1896,6 @@ int pw_context_conf_section_match_rules(struct pw_context *context, const char *
 			const char *str, size_t len),
 		void *data)
 {
-	return pw_conf_section_match_rules(&context->conf->dict, section,
+	return section_match_rules(context, &context->conf->dict, section,
 			props, callback, data);
 }
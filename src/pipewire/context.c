@@ -19,6 +19,7 @@
 #include <spa/node/utils.h>
 #include <spa/utils/atomic.h>
 #include <spa/utils/names.h>
+#include <spa/utils/json.h>
 #include <spa/utils/string.h>
 #include <spa/debug/types.h>
 
@@ -48,8 +49,134 @@ struct factory_entry {
 	regex_t regex;
 	char *lib;
 };
+
+#define MAX_FACTORY_LIB_CACHE	64
+
+struct factory_lib {
+	char *factory_name;
+	const char *lib;
+};
+
+#define MAX_FORMAT_CACHE	64
+
+/* result of a format negotiation between two ports that both needed a
+ * format, the key is the EnumFormat params of the input and output port */
+struct format_entry {
+	struct spa_list link;
+	uint32_t hash;
+	size_t key_size;
+	void *key;
+	struct spa_pod *format;
+};
 /** \endcond */
 
+static int collect_param(void *data, int seq, uint32_t id, uint32_t index,
+		uint32_t next, struct spa_pod *param)
+{
+	struct pw_array *key = data;
+	uint32_t size = SPA_ROUND_UP_N(SPA_POD_SIZE(param), 8);
+	void *p;
+
+	if ((p = pw_array_add(key, size)) == NULL)
+		return -errno;
+	/* clear the padding, the key is compared as bytes */
+	memset(SPA_PTROFF(p, size - 8, void), 0, 8);
+	memcpy(p, param, SPA_POD_SIZE(param));
+	return 0;
+}
+
+static int format_cache_key(struct pw_impl_port *port, struct pw_array *key)
+{
+	size_t start = key->size;
+	int res;
+	uint32_t *end;
+
+	if ((res = pw_impl_port_for_each_param(port, 0, SPA_PARAM_EnumFormat,
+				0, 0, NULL, collect_param, key)) < 0)
+		return res;
+	/* an async result or a port without formats gives no usable key */
+	if (res != 0 || key->size == start)
+		return -EAGAIN;
+	/* end of the params of this port */
+	if ((end = pw_array_add(key, 2 * sizeof(uint32_t))) == NULL)
+		return -errno;
+	end[0] = end[1] = SPA_ID_INVALID;
+	return 0;
+}
+
+static uint32_t format_cache_hash(const struct pw_array *key)
+{
+	const uint8_t *p = key->data;
+	uint32_t hash = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < key->size; i++)
+		hash = (hash ^ p[i]) * 16777619u;
+	return hash;
+}
+
+static void format_entry_free(struct format_entry *e)
+{
+	spa_list_remove(&e->link);
+	free(e->key);
+	free(e->format);
+	free(e);
+}
+
+static void format_cache_clear(struct pw_context *context)
+{
+	struct format_entry *e;
+	spa_list_consume(e, &context->format_cache, link)
+		format_entry_free(e);
+	context->n_format_cache = 0;
+}
+
+static struct format_entry *format_cache_find(struct pw_context *context,
+		const struct pw_array *key, uint32_t hash)
+{
+	struct format_entry *e;
+
+	spa_list_for_each(e, &context->format_cache, link) {
+		if (e->hash == hash && e->key_size == key->size &&
+		    memcmp(e->key, key->data, key->size) == 0) {
+			/* move to the front, the last entry is evicted first */
+			spa_list_remove(&e->link);
+			spa_list_prepend(&context->format_cache, &e->link);
+			return e;
+		}
+	}
+	return NULL;
+}
+
+static void format_cache_add(struct pw_context *context,
+		const struct pw_array *key, uint32_t hash, const struct spa_pod *format)
+{
+	struct format_entry *e;
+
+	if ((e = calloc(1, sizeof(*e))) == NULL)
+		return;
+	e->hash = hash;
+	e->key_size = key->size;
+	e->key = malloc(key->size);
+	e->format = spa_pod_copy(format);
+	if (e->key == NULL || e->format == NULL) {
+		free(e->key);
+		free(e->format);
+		free(e);
+		return;
+	}
+	memcpy(e->key, key->data, key->size);
+
+	if (context->n_format_cache >= MAX_FORMAT_CACHE) {
+		format_entry_free(spa_list_last(&context->format_cache,
+					struct format_entry, link));
+		context->n_format_cache--;
+	}
+	spa_list_prepend(&context->format_cache, &e->link);
+	context->n_format_cache++;
+}
+
+
 static void fill_properties(struct pw_context *context)
 {
 	struct pw_properties *properties = context->properties;
@@ -161,6 +288,39 @@ static int do_data_loop_setup(struct spa_loop *loop, bool async, uint32_t seq,
 	return 0;
 }
 
+static void factory_lib_cache_clear(struct pw_context *context)
+{
+	struct factory_lib *cached;
+
+	pw_array_for_each(cached, &context->factory_lib_cache)
+		free(cached->factory_name);
+	pw_array_reset(&context->factory_lib_cache);
+}
+
+static void preload_spa_factories(struct pw_context *context, const char *str)
+{
+	struct spa_json it[2];
+	char name[256];
+	const char *lib;
+	int res;
+
+	spa_json_init(&it[0], str, strlen(str));
+	if (spa_json_enter_array(&it[0], &it[1]) <= 0)
+		spa_json_init(&it[1], str, strlen(str));
+
+	while (spa_json_get_string(&it[1], name, sizeof(name)) > 0) {
+		if ((lib = pw_context_find_spa_lib(context, name)) == NULL) {
+			pw_log_warn("%p: no library to preload %s", context, name);
+			continue;
+		}
+		if ((res = pw_preload_spa_factory(lib, name)) < 0)
+			pw_log_warn("%p: can't preload %s from %s: %s", context,
+					name, lib, spa_strerror(res));
+		else
+			pw_log_info("%p: preloaded %s from %s", context, name, lib);
+	}
+}
+
 /** Create a new context object
  *
  * \param main_loop the main loop to use
@@ -197,6 +357,7 @@ struct pw_context *pw_context_new(struct pw_loop *main_loop,
 		this->user_data = SPA_PTROFF(impl, sizeof(struct impl), void);
 
 	pw_array_init(&this->factory_lib, 32);
+	pw_array_init(&this->factory_lib_cache, 32);
 	pw_array_init(&this->objects, 32);
 	pw_map_init(&this->globals, 128, 32);
 
@@ -216,6 +377,11 @@ struct pw_context *pw_context_new(struct pw_loop *main_loop,
 	spa_list_init(&this->control_list[1]);
 	spa_list_init(&this->export_list);
 	spa_list_init(&this->driver_list);
+	spa_list_init(&this->buffer_cache);
+	spa_list_init(&this->format_cache);
+	spa_list_init(&this->conf_rules);
+	spa_list_init(&this->latency_list);
+	this->latency_work = SPA_ID_INVALID;
 	spa_hook_list_init(&this->listener_list);
 	spa_hook_list_init(&this->driver_listener_list);
 
@@ -285,11 +451,17 @@ struct pw_context *pw_context_new(struct pw_loop *main_loop,
 		goto error_free;
 	}
 
-	this->pool = pw_mempool_new(NULL);
+	this->pool = pw_mempool_new(pw_properties_new(
+			"mem.prefault", pw_properties_get(properties, "mem.prefault"),
+			"mem.mlock-buffers", pw_properties_get(properties, "mem.mlock-buffers"),
+			NULL));
 	if (this->pool == NULL) {
 		res = -errno;
 		goto error_free;
 	}
+	pw_mempool_set_arena_size(this->pool,
+			pw_properties_get_uint32(properties, "mem.arena-size", 0));
+	this->max_buffer_cache = pw_properties_get_uint64(properties, "mem.buffer-cache", 0);
 
 	this->data_loop = pw_data_loop_get_loop(impl->data_loop_impl);
 	this->data_system = this->data_loop->system;
@@ -344,6 +516,8 @@ struct pw_context *pw_context_new(struct pw_loop *main_loop,
 	if ((res = pw_context_parse_conf_section(this, conf, "context.spa-libs")) < 0)
 		goto error_free;
 	pw_log_info("%p: parsed %d context.spa-libs items", this, res);
+	if ((str = pw_properties_get(properties, "spa.preload-factories")) != NULL)
+		preload_spa_factories(this, str);
 	if ((res = pw_context_parse_conf_section(this, conf, "context.modules")) < 0)
 		goto error_free;
 	if (res > 0)
@@ -434,6 +608,10 @@ void pw_context_destroy(struct pw_context *context)
 	if (impl->data_loop_impl)
 		pw_data_loop_destroy(impl->data_loop_impl);
 
+	pw_buffers_cache_flush(context, NULL);
+	format_cache_clear(context);
+	pw_context_conf_rules_clear(context);
+
 	if (context->pool)
 		pw_mempool_destroy(context->pool);
 
@@ -448,6 +626,9 @@ void pw_context_destroy(struct pw_context *context)
 	if (impl->dbus_handle)
 		pw_unload_spa_handle(impl->dbus_handle);
 
+	factory_lib_cache_clear(context);
+	pw_array_clear(&context->factory_lib_cache);
+
 	pw_array_for_each(entry, &context->factory_lib) {
 		regfree(&entry->regex);
 		free(entry->lib);
@@ -655,6 +836,11 @@ int pw_context_find_format(struct pw_context *context,
 	struct spa_pod_builder fb = { 0 };
 	uint8_t fbuf[4096];
 	struct spa_pod *filter;
+	struct pw_array key;
+	uint32_t hash = 0;
+	bool cache = false;
+
+	pw_array_init(&key, 4096);
 
 	out_state = output->state;
 	in_state = input->state;
@@ -728,6 +914,30 @@ int pw_context_find_format(struct pw_context *context,
 			}
 		}
 	} else if (in_state == PW_IMPL_PORT_STATE_CONFIGURE && out_state == PW_IMPL_PORT_STATE_CONFIGURE) {
+		struct format_entry *e;
+
+		/* ports with the same formats negotiate to the same result, look it up
+		 * with the complete EnumFormat params of both ports */
+		cache = format_cache_key(input, &key) >= 0 &&
+			format_cache_key(output, &key) >= 0;
+		if (cache) {
+			hash = format_cache_hash(&key);
+			if ((e = format_cache_find(context, &key, hash)) != NULL) {
+				uint32_t offset = builder->state.offset;
+
+				pw_log_debug("%p: use cached format %08x", context, hash);
+				if ((res = spa_pod_builder_raw_padded(builder, e->format,
+							SPA_POD_SIZE(e->format))) < 0) {
+					*error = spa_aprintf("error copy cached format: %s",
+							spa_strerror(res));
+					goto error;
+				}
+				*format = spa_pod_builder_deref(builder, offset);
+				pw_log_format(SPA_LOG_LEVEL_DEBUG, *format);
+				pw_array_clear(&key);
+				return 1;
+			}
+		}
 	      again:
 		/* both ports need a format */
 		pw_log_debug("%p: do enum input %d", context, iidx);
@@ -764,13 +974,18 @@ int pw_context_find_format(struct pw_context *context,
 
 		pw_log_debug("%p: Got filtered:", context);
 		pw_log_format(SPA_LOG_LEVEL_DEBUG, *format);
+
+		if (cache)
+			format_cache_add(context, &key, hash, *format);
 	} else {
 		res = -EBADF;
 		*error = spa_aprintf("error bad node state");
 		goto error;
 	}
+	pw_array_clear(&key);
 	return res;
 error:
+	pw_array_clear(&key);
 	if (res == 0)
 		res = -EINVAL;
 	return res;
@@ -1539,6 +1754,9 @@ int pw_context_add_spa_lib(struct pw_context *context,
 	entry->lib = strdup(lib);
 	pw_log_debug("%p: map factory regex '%s' to '%s", context,
 			factory_regexp, lib);
+
+	/* the new mapping can resolve factories that had no library before */
+	factory_lib_cache_clear(context);
 	return 0;
 }
 
@@ -1546,12 +1764,32 @@ SPA_EXPORT
 const char *pw_context_find_spa_lib(struct pw_context *context, const char *factory_name)
 {
 	struct factory_entry *entry;
+	struct factory_lib *cached;
+	const char *lib = NULL;
+
+	pw_array_for_each(cached, &context->factory_lib_cache) {
+		if (spa_streq(cached->factory_name, factory_name))
+			return cached->lib;
+	}
 
 	pw_array_for_each(entry, &context->factory_lib) {
-		if (regexec(&entry->regex, factory_name, 0, NULL, 0) == 0)
-			return entry->lib;
+		if (regexec(&entry->regex, factory_name, 0, NULL, 0) == 0) {
+			lib = entry->lib;
+			break;
+		}
 	}
-	return NULL;
+
+	if (pw_array_get_len(&context->factory_lib_cache, struct factory_lib) >= MAX_FACTORY_LIB_CACHE)
+		factory_lib_cache_clear(context);
+
+	cached = pw_array_add(&context->factory_lib_cache, sizeof(*cached));
+	if (cached != NULL) {
+		if ((cached->factory_name = strdup(factory_name)) == NULL)
+			pw_array_remove(&context->factory_lib_cache, cached);
+		else
+			cached->lib = lib;
+	}
+	return lib;
 }
 
 SPA_EXPORT
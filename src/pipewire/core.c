@@ -319,7 +319,10 @@ static struct pw_core *core_new(struct pw_context *context,
 
 	p->context = context;
 	p->properties = properties;
-	p->pool = pw_mempool_new(NULL);
+	p->pool = pw_mempool_new(pw_properties_new(
+			"mem.prefault", pw_properties_get(properties, "mem.prefault"),
+			"mem.mlock-buffers", pw_properties_get(properties, "mem.mlock-buffers"),
+			NULL));
 	if (user_data_size > 0)
 		p->user_data = SPA_PTROFF(p, sizeof(struct pw_core), void);
 	p->proxy.user_data = p->user_data;
@@ -39,10 +39,34 @@ void pw_data_loop_exit(struct pw_data_loop *this)
 	this->running = false;
 }
 
+static void count_faults(struct pw_data_loop *this, struct rusage *last)
+{
+#ifdef RUSAGE_THREAD
+	struct rusage ru;
+	uint64_t minor, major;
+
+	if (getrusage(RUSAGE_THREAD, &ru) < 0)
+		return;
+
+	minor = ru.ru_minflt - last->ru_minflt;
+	major = ru.ru_majflt - last->ru_majflt;
+	if (SPA_UNLIKELY(minor > 0 || major > 0)) {
+		this->minor_faults += minor;
+		this->major_faults += major;
+		pw_log_debug("%p: %"PRIu64" minor %"PRIu64" major page faults, total %"PRIu64" %"PRIu64,
+				this, minor, major, this->minor_faults, this->major_faults);
+	}
+	*last = ru;
+#endif
+}
+
 static void thread_cleanup(void *arg)
 {
 	struct pw_data_loop *this = arg;
 	pw_log_debug("%p: leave thread", this);
+	if (this->count_faults)
+		pw_log_info("%p: %"PRIu64" minor and %"PRIu64" major page faults",
+				this, this->minor_faults, this->major_faults);
 	this->running = false;
 	pw_loop_leave(this->loop);
 }
@@ -55,12 +79,18 @@ static void *do_loop(void *user_data)
 	const struct spa_loop_control_methods *m = cb->funcs;
 	void *data = cb->data;
 	int (*iterate) (void *object, int timeout) = m->iterate;
+	struct rusage last;
 
 	pw_log_debug("%p: enter thread", this);
 	pw_loop_enter(this->loop);
 
 	pthread_cleanup_push(thread_cleanup, this);
 
+	spa_zero(last);
+	if (this->count_faults)
+		count_faults(this, &last);
+	this->minor_faults = this->major_faults = 0;
+
 	while (SPA_LIKELY(this->running)) {
 		if (SPA_UNLIKELY((res = iterate(data, -1)) < 0)) {
 			if (res == -EINTR)
@@ -68,6 +98,8 @@ static void *do_loop(void *user_data)
 			pw_log_error("%p: iterate error %d (%s)",
 					this, res, spa_strerror(res));
 		}
+		if (SPA_UNLIKELY(this->count_faults))
+			count_faults(this, &last);
 	}
 	pthread_cleanup_pop(1);
 
@@ -111,6 +143,9 @@ static struct pw_data_loop *loop_new(struct pw_loop *loop, const struct spa_dict
 	if (props != NULL &&
 	    (str = spa_dict_lookup(props, "loop.cancel")) != NULL)
 		this->cancel = pw_properties_parse_bool(str);
+	if (props != NULL &&
+	    (str = spa_dict_lookup(props, "loop.count-faults")) != NULL)
+		this->count_faults = pw_properties_parse_bool(str);
 
 	spa_hook_list_init(&this->listener_list);
 
@@ -773,7 +773,7 @@ static void input_remove(struct pw_impl_link *this, struct pw_impl_port *port)
 	spa_list_remove(&this->input_link);
 	pw_impl_port_emit_link_removed(this->input, this);
 
-	pw_impl_port_recalc_latency(this->input);
+	pw_impl_port_schedule_latency(this->input);
 
 	if ((res = pw_impl_port_use_buffers(port, mix, 0, NULL, 0)) < 0) {
 		pw_log_warn("%p: port %p clear error %s", this, port, spa_strerror(res));
@@ -802,7 +802,7 @@ static void output_remove(struct pw_impl_link *this, struct pw_impl_port *port)
 	spa_list_remove(&this->output_link);
 	pw_impl_port_emit_link_removed(this->output, this);
 
-	pw_impl_port_recalc_latency(this->output);
+	pw_impl_port_schedule_latency(this->output);
 
 	/* we don't clear output buffers when the link goes away. They will get
 	 * cleared when the node goes to suspend */
@@ -985,7 +985,7 @@ static void input_port_latency_changed(void *data)
 	struct impl *impl = data;
 	struct pw_impl_link *this = &impl->this;
 	if (!this->feedback)
-		pw_impl_port_recalc_latency(this->output);
+		pw_impl_port_schedule_latency(this->output);
 }
 
 static void output_port_latency_changed(void *data)
@@ -993,7 +993,7 @@ static void output_port_latency_changed(void *data)
 	struct impl *impl = data;
 	struct pw_impl_link *this = &impl->this;
 	if (!this->feedback)
-		pw_impl_port_recalc_latency(this->input);
+		pw_impl_port_schedule_latency(this->input);
 }
 
 static const struct pw_impl_port_events input_port_events = {
@@ -1393,8 +1393,8 @@ struct pw_impl_link *pw_context_create_link(struct pw_context *context,
 
 	try_link_controls(impl, output, input);
 
-	pw_impl_port_recalc_latency(output);
-	pw_impl_port_recalc_latency(input);
+	pw_impl_port_schedule_latency(output);
+	pw_impl_port_schedule_latency(input);
 
 	if (impl->onode != impl->inode)
 		this->peer = pw_node_peer_ref(impl->onode, impl->inode);
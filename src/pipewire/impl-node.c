@@ -2068,6 +2068,9 @@ void pw_impl_node_destroy(struct pw_impl_node *node)
 	spa_list_consume(port, &node->output_ports, link)
 		pw_impl_port_destroy(port);
 
+	if (node->node)
+		pw_buffers_cache_flush(context, node->node);
+
 	if (node->global) {
 		spa_hook_remove(&node->global_listener);
 		pw_global_destroy(node->global);
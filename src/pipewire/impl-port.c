@@ -1282,6 +1282,10 @@ void pw_impl_port_destroy(struct pw_impl_port *port)
 	pw_log_debug("%p: destroy", port);
 
 	port->destroying = true;
+	if (port->latency_pending) {
+		spa_list_remove(&port->latency_link);
+		port->latency_pending = false;
+	}
 	pw_impl_port_emit_destroy(port);
 
 	pw_impl_port_unlink(port);
@@ -1572,6 +1576,54 @@ int pw_impl_port_recalc_latency(struct pw_impl_port *port)
 	return pw_impl_port_set_param(port, SPA_PARAM_Latency, 0, param);
 }
 
+static void do_recalc_latency(void *obj, void *data, int res, uint32_t id)
+{
+	struct pw_context *context = obj;
+	struct pw_impl_port *port;
+	struct spa_list pending;
+	uint32_t n_ports = 0, n_rounds = 0;
+
+	context->latency_work = SPA_ID_INVALID;
+
+	/* Every round recalculates the ports that became dirty in the previous
+	 * round, in the order they were scheduled. Ports that are scheduled
+	 * again before their turn are only recalculated once. */
+	while (!spa_list_is_empty(&context->latency_list)) {
+		spa_list_init(&pending);
+		spa_list_insert_list(&pending, &context->latency_list);
+		spa_list_init(&context->latency_list);
+
+		spa_list_consume(port, &pending, latency_link) {
+			spa_list_remove(&port->latency_link);
+			port->latency_pending = false;
+			pw_impl_port_recalc_latency(port);
+			n_ports++;
+		}
+		n_rounds++;
+	}
+	pw_log_debug("%p: recalculated latency of %u ports in %u rounds",
+			context, n_ports, n_rounds);
+}
+
+/** Schedule a latency recalculation of \a port. All scheduled ports are
+ * recalculated together in the next main loop iteration. */
+void pw_impl_port_schedule_latency(struct pw_impl_port *port)
+{
+	struct pw_context *context;
+
+	if (port->destroying || port->latency_pending || port->node == NULL)
+		return;
+
+	context = port->node->context;
+
+	spa_list_append(&context->latency_list, &port->latency_link);
+	port->latency_pending = true;
+
+	if (context->latency_work == SPA_ID_INVALID)
+		context->latency_work = pw_work_queue_add(context->work_queue,
+				context, 0, do_recalc_latency, NULL);
+}
+
 SPA_EXPORT
 int pw_impl_port_is_linked(struct pw_impl_port *port)
 {
@@ -21,6 +21,7 @@
 #include <pipewire/log.h>
 #include <pipewire/map.h>
 #include <pipewire/mem.h>
+#include <pipewire/properties.h>
 
 PW_LOG_TOPIC_EXTERN(log_mem);
 #define PW_LOG_TOPIC_DEFAULT log_mem
@@ -46,6 +47,10 @@ static inline int memfd_create(const char *name, unsigned int flags)
 #define MAP_LOCKED 0
 #endif
 
+#ifndef MAP_POPULATE
+#define MAP_POPULATE 0
+#endif
+
 /* memfd_create(2) flags */
 
 #ifndef MFD_CLOEXEC
@@ -85,6 +90,13 @@ struct mempool {
 	struct pw_map map;		/* map memblock to id */
 	struct spa_list blocks;		/* list of memblock */
 	uint32_t pagesize;
+
+	uint32_t arena_size;
+	struct spa_list arenas;		/* list of arena */
+
+	unsigned int prefault:1;	/* fault in all pages when mapping */
+	unsigned int mlock:1;		/* lock all mappings in memory */
+	unsigned int mlock_warned:1;
 };
 
 struct memblock {
@@ -112,6 +124,21 @@ struct memmap {
 	struct spa_list link;
 };
 
+/* a mapped block that is carved into ranges */
+struct arena {
+	struct spa_list link;		/* link in mempool */
+	struct pw_memblock *block;
+	struct spa_list ranges;		/* list of memrange, sorted on offset */
+};
+
+struct memrange {
+	struct pw_memrange this;
+	struct arena *arena;
+	struct spa_list link;		/* link in arena */
+};
+
+#define RANGE_ALIGN	64u
+
 SPA_EXPORT
 struct pw_mempool *pw_mempool_new(struct pw_properties *props)
 {
@@ -127,23 +154,45 @@ struct pw_mempool *pw_mempool_new(struct pw_properties *props)
 
 	impl->pagesize = sysconf(_SC_PAGESIZE);
 
-	pw_log_debug("%p: new", this);
+	if (props != NULL) {
+		impl->prefault = pw_properties_get_bool(props, "mem.prefault", false);
+		impl->mlock = pw_properties_get_bool(props, "mem.mlock-buffers", false);
+	}
+
+	pw_log_debug("%p: new prefault:%d mlock:%d", this, impl->prefault, impl->mlock);
 
 	spa_hook_list_init(&impl->listener_list);
 	pw_map_init(&impl->map, 64, 64);
 	spa_list_init(&impl->blocks);
+	spa_list_init(&impl->arenas);
 
 	return this;
 }
 
+static void arena_free(struct arena *a)
+{
+	struct memrange *r;
+
+	spa_list_consume(r, &a->ranges, link) {
+		spa_list_remove(&r->link);
+		free(r);
+	}
+	spa_list_remove(&a->link);
+	pw_memblock_unref(a->block);
+	free(a);
+}
+
 SPA_EXPORT
 void pw_mempool_clear(struct pw_mempool *pool)
 {
 	struct mempool *impl = SPA_CONTAINER_OF(pool, struct mempool, this);
 	struct memblock *b;
+	struct arena *a;
 
 	pw_log_debug("%p: clear", pool);
 
+	spa_list_consume(a, &impl->arenas, link)
+		arena_free(a);
 	spa_list_consume(b, &impl->blocks, link)
 		pw_memblock_free(&b->this);
 	pw_map_reset(&impl->map);
@@ -277,6 +326,8 @@ static struct mapping * memblock_map(struct memblock *b,
 
 	if (flags & PW_MEMMAP_FLAG_LOCKED)
 		fl |= MAP_LOCKED;
+	if (p->prefault)
+		fl |= MAP_POPULATE;
 
 	if (flags & PW_MEMMAP_FLAG_TWICE) {
 		pw_log_error("%p: implement me PW_MEMMAP_FLAG_TWICE", p);
@@ -292,6 +343,16 @@ static struct mapping * memblock_map(struct memblock *b,
 		return NULL;
 	}
 
+	if (p->mlock && mlock(ptr, size) < 0) {
+		if (errno != ENOMEM || !p->mlock_warned) {
+			pw_log_warn("%p: Failed to mlock memory fd:%d %p %u: %s", p,
+					b->this.fd, ptr, size,
+					errno == ENOMEM ?
+					"consider increasing RLIMIT_MEMLOCK" : strerror(errno));
+			p->mlock_warned |= errno == ENOMEM;
+		}
+	}
+
 	m = calloc(1, sizeof(struct mapping));
 	if (m == NULL) {
 		munmap(ptr, size);
@@ -560,6 +621,119 @@ error_free:
 	return NULL;
 }
 
+SPA_EXPORT
+void pw_mempool_set_arena_size(struct pw_mempool *pool, uint32_t size)
+{
+	struct mempool *impl = SPA_CONTAINER_OF(pool, struct mempool, this);
+	impl->arena_size = size ? SPA_ROUND_UP_N(size, impl->pagesize) : 0;
+	pw_log_debug("%p: arena size %u", pool, impl->arena_size);
+}
+
+static struct memrange *arena_alloc_range(struct arena *a, uint32_t size)
+{
+	struct memrange *r, *next;
+	uint32_t offset = 0;
+
+	/* first fit, ranges are sorted on offset */
+	spa_list_for_each(next, &a->ranges, link) {
+		if (next->this.offset - offset >= size)
+			break;
+		offset = SPA_ROUND_UP_N(next->this.offset + next->this.size, RANGE_ALIGN);
+	}
+	if (&next->link == &a->ranges && a->block->size - SPA_MIN(offset, a->block->size) < size)
+		return NULL;
+
+	r = calloc(1, sizeof(struct memrange));
+	if (r == NULL)
+		return NULL;
+
+	r->arena = a;
+	r->this.block = a->block;
+	r->this.offset = offset;
+	r->this.size = size;
+	r->this.ptr = SPA_PTROFF(a->block->map->ptr, offset, void);
+	spa_list_append(&next->link, &r->link);
+	return r;
+}
+
+/** Allocate a range of memory
+ * \param pool the pool to use
+ * \param flags memblock flags, the block is always mapped
+ * \param type the requested memory type one of enum spa_data_type
+ * \param size size to allocate
+ * \return a memrange structure or NULL with errno on error
+ *
+ * When the pool has an arena size, the range is carved out of an existing
+ * block with the same flags and type when possible, so that many ranges
+ * share one fd and one mapping. Otherwise a new block is allocated for
+ * the range.
+ */
+SPA_EXPORT
+struct pw_memrange * pw_mempool_alloc_range(struct pw_mempool *pool, enum pw_memblock_flags flags,
+		uint32_t type, size_t size)
+{
+	struct mempool *impl = SPA_CONTAINER_OF(pool, struct mempool, this);
+	struct arena *a;
+	struct memrange *r;
+
+	flags |= PW_MEMBLOCK_FLAG_MAP;
+
+	if (size == 0 || size > UINT32_MAX) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (size <= impl->arena_size) {
+		spa_list_for_each(a, &impl->arenas, link) {
+			if (a->block->flags != flags || a->block->type != type)
+				continue;
+			if ((r = arena_alloc_range(a, size)) != NULL)
+				goto done;
+		}
+	}
+
+	a = calloc(1, sizeof(struct arena));
+	if (a == NULL)
+		return NULL;
+
+	a->block = pw_mempool_alloc(pool, flags, type, SPA_MAX(size, (size_t)impl->arena_size));
+	if (a->block == NULL) {
+		free(a);
+		return NULL;
+	}
+	spa_list_init(&a->ranges);
+	spa_list_append(&impl->arenas, &a->link);
+
+	if ((r = arena_alloc_range(a, size)) == NULL) {
+		arena_free(a);
+		return NULL;
+	}
+done:
+	pw_log_debug("%p: range:%p block:%p id:%u offset:%u size:%u", pool, r,
+			r->this.block, r->this.block->id, r->this.offset, r->this.size);
+	return &r->this;
+}
+
+/** Free a range of memory
+ * \param range the memrange to free
+ *
+ * The block of the range is freed when it has no more ranges.
+ */
+SPA_EXPORT
+void pw_memrange_free(struct pw_memrange *range)
+{
+	struct memrange *r = SPA_CONTAINER_OF(range, struct memrange, this);
+	struct arena *a = r->arena;
+
+	pw_log_debug("%p: range:%p block:%p id:%u offset:%u size:%u", range->block->pool,
+			r, range->block, range->block->id, range->offset, range->size);
+
+	spa_list_remove(&r->link);
+	free(r);
+
+	if (spa_list_is_empty(&a->ranges))
+		arena_free(a);
+}
+
 static struct memblock * mempool_find_fd(struct pw_mempool *pool, int fd)
 {
 	struct mempool *impl = SPA_CONTAINER_OF(pool, struct mempool, this);
@@ -76,6 +76,14 @@ struct pw_memmap {
 	uint32_t tag[5];		/**< user tag */
 };
 
+/** a range of memory in a mapped pw_memblock */
+struct pw_memrange {
+	struct pw_memblock *block;	/**< memblock that contains the range */
+	void *ptr;			/**< mapped pointer */
+	uint32_t offset;		/**< offset in memblock */
+	uint32_t size;			/**< size of the range */
+};
+
 struct pw_mempool_events {
 #define PW_VERSION_MEMPOOL_EVENTS	0
 	uint32_t version;
@@ -110,6 +118,18 @@ void pw_mempool_destroy(struct pw_mempool *pool);
 struct pw_memblock * pw_mempool_alloc(struct pw_mempool *pool,
 		enum pw_memblock_flags flags, uint32_t type, size_t size);
 
+/** Set the size of the blocks that ranges are allocated from, 0 allocates
+ * a new block for each range. Ranges from the same block share the fd and
+ * its mapping, any peer that gets the block can access all of its ranges. Since 0.3.78 */
+void pw_mempool_set_arena_size(struct pw_mempool *pool, uint32_t size);
+
+/** Allocate a range of memory from the pool. Since 0.3.78 */
+struct pw_memrange * pw_mempool_alloc_range(struct pw_mempool *pool,
+		enum pw_memblock_flags flags, uint32_t type, size_t size);
+
+/** Free a range of memory. Since 0.3.78 */
+void pw_memrange_free(struct pw_memrange *range);
+
 /** Import a block from another pool */
 struct pw_memblock * pw_mempool_import_block(struct pw_mempool *pool,
 		struct pw_memblock *mem);
@@ -57,9 +57,19 @@ struct handle {
 	struct spa_handle handle SPA_ALIGNED(8);
 };
 
+struct factory {
+	struct spa_list link;
+	struct plugin *plugin;
+	char *lib;
+	char *factory_name;
+	const struct spa_handle_factory *factory;
+	unsigned int preloaded:1;
+};
+
 struct registry {
 	struct spa_list plugins;
 	struct spa_list handles; /* all handles across all plugins by age (youngest first) */
+	struct spa_list factories; /* resolved factories of the loaded plugins */
 };
 
 struct support {
@@ -74,6 +84,7 @@ struct support {
 	unsigned int in_valgrind:1;
 	unsigned int no_color:1;
 	unsigned int no_config:1;
+	unsigned int config_cache:1;
 	unsigned int do_dlclose:1;
 };
 
@@ -143,10 +154,64 @@ error_out:
 	return NULL;
 }
 
+static struct factory *
+find_cached_factory(struct registry *registry, const char *lib, const char *factory_name)
+{
+	struct factory *f;
+	spa_list_for_each(f, &registry->factories, link) {
+		if (spa_streq(f->factory_name, factory_name) &&
+		    spa_streq(f->lib, lib))
+			return f;
+	}
+	return NULL;
+}
+
+static struct factory *
+add_cached_factory(struct registry *registry, struct plugin *plugin,
+		const char *lib, const char *factory_name,
+		const struct spa_handle_factory *factory)
+{
+	struct factory *f;
+
+	if ((f = find_cached_factory(registry, lib, factory_name)) != NULL)
+		return f;
+
+	if ((f = calloc(1, sizeof(struct factory))) == NULL)
+		return NULL;
+
+	f->lib = strdup(lib);
+	f->factory_name = strdup(factory_name);
+	if (f->lib == NULL || f->factory_name == NULL) {
+		free(f->lib);
+		free(f->factory_name);
+		free(f);
+		return NULL;
+	}
+	f->plugin = plugin;
+	f->factory = factory;
+	spa_list_append(&registry->factories, &f->link);
+
+	return f;
+}
+
+static void free_cached_factories(struct registry *registry, struct plugin *plugin)
+{
+	struct factory *f, *t;
+	spa_list_for_each_safe(f, t, &registry->factories, link) {
+		if (f->plugin != plugin)
+			continue;
+		spa_list_remove(&f->link);
+		free(f->lib);
+		free(f->factory_name);
+		free(f);
+	}
+}
+
 static void
 unref_plugin(struct plugin *plugin)
 {
 	if (--plugin->ref == 0) {
+		free_cached_factories(&global_support.registry, plugin);
 		spa_list_remove(&plugin->link);
 		pw_log_debug("unloaded plugin:'%s'", plugin->filename);
 		if (global_support.do_dlclose)
@@ -206,6 +271,58 @@ uint32_t pw_get_support(struct spa_support *support, uint32_t max_support)
 	return n;
 }
 
+/* Find the factory in lib and take a ref on its plugin. Factories that
+ * were resolved before are found in the cache without scanning the plugin
+ * path and enumerating the factories of the plugin again.
+ * Must be called with the support_lock held. */
+static const struct spa_handle_factory *lookup_factory(struct support *sup,
+		const char *lib, const char *factory_name, struct plugin **plugin)
+{
+	struct registry *registry = &sup->registry;
+	struct plugin *pl = NULL;
+	struct factory *f;
+	const struct spa_handle_factory *factory;
+	const char *state = NULL, *p;
+	int res = -ENOENT;
+	size_t len;
+
+	if ((f = find_cached_factory(registry, lib, factory_name)) != NULL) {
+		f->plugin->ref++;
+		*plugin = f->plugin;
+		return f->factory;
+	}
+
+	if (sup->plugin_dir == NULL) {
+		pw_log_error("load lib: plugin directory undefined, set SPA_PLUGIN_DIR");
+		goto error_out;
+	}
+	while ((p = pw_split_walk(sup->plugin_dir, ":", &len, &state))) {
+		if ((pl = open_plugin(registry, p, len, lib)) != NULL)
+			break;
+		res = -errno;
+	}
+	if (pl == NULL)
+		goto error_out;
+
+	pthread_mutex_unlock(&support_lock);
+	factory = find_factory(pl, factory_name);
+	res = factory == NULL ? -errno : 0;
+	pthread_mutex_lock(&support_lock);
+
+	if (factory == NULL) {
+		unref_plugin(pl);
+		goto error_out;
+	}
+	add_cached_factory(registry, pl, lib, factory_name, factory);
+
+	*plugin = pl;
+	return factory;
+
+error_out:
+	errno = -res;
+	return NULL;
+}
+
 static struct spa_handle *load_spa_handle(const char *lib,
 		const char *factory_name,
 		const struct spa_dict *info,
@@ -216,9 +333,7 @@ static struct spa_handle *load_spa_handle(const char *lib,
 	struct plugin *plugin;
 	struct handle *handle;
 	const struct spa_handle_factory *factory;
-	const char *state = NULL, *p;
 	int res;
-	size_t len;
 
 	if (factory_name == NULL) {
 		res = -EINVAL;
@@ -230,29 +345,13 @@ static struct spa_handle *load_spa_handle(const char *lib,
 
 	pw_log_debug("load lib:'%s' factory-name:'%s'", lib, factory_name);
 
-	plugin = NULL;
-	res = -ENOENT;
-
-	if (sup->plugin_dir == NULL) {
-		pw_log_error("load lib: plugin directory undefined, set SPA_PLUGIN_DIR");
-		goto error_out;
-	}
-	while ((p = pw_split_walk(sup->plugin_dir, ":", &len, &state))) {
-		if ((plugin = open_plugin(&sup->registry, p, len, lib)) != NULL)
-			break;
+	if ((factory = lookup_factory(sup, lib, factory_name, &plugin)) == NULL) {
 		res = -errno;
-	}
-	if (plugin == NULL)
 		goto error_out;
+	}
 
 	pthread_mutex_unlock(&support_lock);
 
-	factory = find_factory(plugin, factory_name);
-	if (factory == NULL) {
-		res = -errno;
-		goto error_unref_plugin;
-	}
-
 	handle = calloc(1, sizeof(struct handle) + spa_handle_factory_get_size(factory, info));
 	if (handle == NULL) {
 		res = -errno;
@@ -299,6 +398,36 @@ struct spa_handle *pw_load_spa_handle(const char *lib,
 	return handle;
 }
 
+/* Load the plugin with the factory and keep it loaded until pw_deinit() so
+ * that handles can later be made without touching the filesystem. */
+int pw_preload_spa_factory(const char *lib, const char *factory_name)
+{
+	struct support *sup = &global_support;
+	struct plugin *plugin;
+	struct factory *f;
+	int res = 0;
+
+	if (factory_name == NULL)
+		return -EINVAL;
+	if (lib == NULL)
+		lib = sup->support_lib;
+
+	pthread_mutex_lock(&support_lock);
+	if (lookup_factory(sup, lib, factory_name, &plugin) == NULL) {
+		res = -errno;
+	} else if ((f = find_cached_factory(&sup->registry, lib, factory_name)) == NULL ||
+	    f->preloaded) {
+		unref_plugin(plugin);
+		res = f == NULL ? -ENOMEM : 0;
+	} else {
+		pw_log_debug("preloaded lib:'%s' factory-name:'%s'", lib, factory_name);
+		f->preloaded = true;
+	}
+	pthread_mutex_unlock(&support_lock);
+
+	return res;
+}
+
 static struct handle *find_handle(struct spa_handle *handle)
 {
 	struct registry *registry = &global_support.registry;
@@ -581,6 +710,9 @@ void pw_init(int *argc, char **argv[])
 	if ((str = getenv("PIPEWIRE_NO_CONFIG")) != NULL)
 		support->no_config = pw_properties_parse_bool(str);
 
+	if ((str = getenv("PIPEWIRE_CONFIG_CACHE")) != NULL)
+		support->config_cache = pw_properties_parse_bool(str);
+
 	init_i18n(support);
 
 	if ((str = getenv("SPA_PLUGIN_DIR")) == NULL)
@@ -593,6 +725,7 @@ void pw_init(int *argc, char **argv[])
 
 	spa_list_init(&support->registry.plugins);
 	spa_list_init(&support->registry.handles);
+	spa_list_init(&support->registry.factories);
 
 	if (pw_log_is_default()) {
 		char *patterns = NULL;
@@ -667,6 +800,7 @@ void pw_deinit(void)
 	struct support *support = &global_support;
 	struct registry *registry = &support->registry;
 	struct handle *h;
+	struct factory *f;
 
 	pthread_mutex_lock(&init_lock);
 	if (support->init_count == 0)
@@ -679,6 +813,14 @@ void pw_deinit(void)
 
 	spa_list_consume(h, &registry->handles, link)
 		unref_handle(h);
+again:
+	spa_list_for_each(f, &registry->factories, link) {
+		if (f->preloaded) {
+			f->preloaded = false;
+			unref_plugin(f->plugin);
+			goto again;
+		}
+	}
 
 	free(support->i18n_domain);
 	spa_zero(global_support);
@@ -797,6 +939,8 @@ bool pw_check_option(const char *option, const char *value)
 		return global_support.no_color == spa_atob(value);
 	else if (spa_streq(option, "no-config"))
 		return global_support.no_config == spa_atob(value);
+	else if (spa_streq(option, "config-cache"))
+		return global_support.config_cache == spa_atob(value);
 	else if (spa_streq(option, "do-dlclose"))
 		return global_support.do_dlclose == spa_atob(value);
 	return false;
@@ -387,6 +387,15 @@ struct pw_context {
 	void *settings_impl;		/**< settings metadata */
 
 	struct pw_mempool *pool;		/**< global memory pool */
+	struct spa_list buffer_cache;		/**< released buffer memory */
+	uint64_t buffer_cache_size;		/**< bytes in the buffer cache */
+	uint64_t max_buffer_cache;		/**< max bytes in the buffer cache */
+	struct spa_list format_cache;		/**< negotiated formats */
+	uint32_t n_format_cache;
+	struct spa_list conf_rules;		/**< compiled match rules */
+	uint32_t n_conf_rules;
+	struct spa_list latency_list;		/**< ports that need latency recalc */
+	uint32_t latency_work;			/**< work id of the pending recalc */
 
 	uint64_t stamp;
 	uint64_t serial;
@@ -421,6 +430,7 @@ struct pw_context {
 	struct spa_support support[16];	/**< support for spa plugins */
 	uint32_t n_support;		/**< number of support items */
 	struct pw_array factory_lib;	/**< mapping of factory_name regexp to library */
+	struct pw_array factory_lib_cache;	/**< resolved factory_name to library */
 
 	struct pw_array objects;	/**< objects */
 
@@ -446,6 +456,10 @@ struct pw_data_loop {
 	unsigned int cancel:1;
 	unsigned int created:1;
 	unsigned int running:1;
+	unsigned int count_faults:1;
+
+	uint64_t minor_faults;		/**< page faults in the loop thread */
+	uint64_t major_faults;
 };
 
 #define pw_main_loop_emit(o,m,v,...) spa_hook_list_call(&o->listener_list, struct pw_main_loop_events, m, v, ##__VA_ARGS__)
@@ -845,6 +859,8 @@ struct pw_impl_port {
 	struct spa_latency_info latency[2];	/**< latencies */
 	unsigned int have_latency_param:1;
 	unsigned int ignore_latency:1;
+	unsigned int latency_pending:1;
+	struct spa_list latency_link;		/**< link in context latency_list */
 
 	void *owner_data;		/**< extra owner data */
 	void *user_data;                /**< extra user data */
@@ -1220,6 +1236,7 @@ int pw_impl_port_use_buffers(struct pw_impl_port *port, struct pw_impl_port_mix
 		struct spa_buffer **buffers, uint32_t n_buffers);
 
 int pw_impl_port_recalc_latency(struct pw_impl_port *port);
+void pw_impl_port_schedule_latency(struct pw_impl_port *port);
 
 /** Change the state of the node */
 int pw_impl_node_set_state(struct pw_impl_node *node, enum pw_node_state state);
@@ -1279,10 +1296,16 @@ void pw_log_deinit(void);
 
 void pw_random_init(void);
 
+int pw_preload_spa_factory(const char *lib, const char *factory_name);
+
 void pw_settings_init(struct pw_context *context);
 int pw_settings_expose(struct pw_context *context);
 void pw_settings_clean(struct pw_context *context);
 
+void pw_buffers_cache_flush(struct pw_context *context, struct spa_node *node);
+
+void pw_context_conf_rules_clear(struct pw_context *context);
+
 /** \endcond */
 
 #ifdef __cplusplus
@@ -0,0 +1,129 @@
+/* PipeWire */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+
+#include <spa/utils/string.h>
+
+#include <pipewire/pipewire.h>
+#include <pipewire/conf.h>
+
+#define N_RULES		256
+#define MAX_COUNT	2000
+
+static char section[N_RULES * 256];
+
+static uint64_t get_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return SPA_TIMESPEC_TO_NSEC(&ts);
+}
+
+static int write_config(const char *path)
+{
+	struct spa_strbuf buf;
+	uint32_t i;
+	FILE *f;
+
+	spa_strbuf_init(&buf, section, sizeof(section));
+	spa_strbuf_append(&buf, "[\n");
+	for (i = 0; i < N_RULES; i++) {
+		if (i % 2)
+			spa_strbuf_append(&buf,
+				"  { matches = [ { application.process.binary = \"~^app%u(-bin)?$\" } ]\n"
+				"    actions = { update-props = { node.latency = %u/48000 } } }\n",
+				i, 256 + i);
+		else
+			spa_strbuf_append(&buf,
+				"  { matches = [ { application.name = \"app%u\" media.role = null }\n"
+				"                { node.name = \"stream.app%u\" } ]\n"
+				"    actions = { update-props = { node.pause-on-idle = false } } }\n",
+				i, i);
+	}
+	spa_strbuf_append(&buf, "]");
+
+	if ((f = fopen(path, "w")) == NULL)
+		return -errno;
+	fprintf(f, "stream.rules = %s\n", section);
+	fclose(f);
+	return 0;
+}
+
+static int matched(void *data, const char *location, const char *action,
+		const char *str, size_t len)
+{
+	uint32_t *count = data;
+	(*count)++;
+	return 0;
+}
+
+static void run_test(struct pw_context *context, const struct spa_dict *props)
+{
+	uint64_t t1, t2, t3;
+	uint32_t i, count1 = 0, count2 = 0;
+
+	t1 = get_time();
+	for (i = 0; i < MAX_COUNT; i++)
+		pw_conf_match_rules(section, strlen(section), NULL, props,
+				matched, &count1);
+	t2 = get_time();
+	for (i = 0; i < MAX_COUNT; i++)
+		pw_context_conf_section_match_rules(context, "stream.rules", props,
+				matched, &count2);
+	t3 = get_time();
+
+	spa_assert_se(count1 == count2);
+
+	fprintf(stderr, "%u rules, %u matched: parsed %"PRIu64"/sec, compiled %"PRIu64"/sec %f speedup\n",
+			N_RULES, count1 / MAX_COUNT,
+			MAX_COUNT * (uint64_t)SPA_NSEC_PER_SEC / (t2 - t1),
+			MAX_COUNT * (uint64_t)SPA_NSEC_PER_SEC / (t3 - t2),
+			(double)(t2 - t1) / (t3 - t2));
+}
+
+int main(int argc, char *argv[])
+{
+	struct pw_main_loop *loop;
+	struct pw_context *context;
+	char dir[] = "/tmp/pw-benchmark-XXXXXX", path[PATH_MAX];
+	static const struct spa_dict_item items[] = {
+		{ PW_KEY_APP_NAME, "app13" },
+		{ PW_KEY_APP_PROCESS_BINARY, "app13-bin" },
+		{ PW_KEY_MEDIA_TYPE, "Audio" },
+		{ PW_KEY_MEDIA_CATEGORY, "Playback" },
+		{ PW_KEY_NODE_NAME, "stream.app128" },
+		{ PW_KEY_CLIENT_API, "pipewire-pulse" },
+	};
+
+	pw_init(&argc, &argv);
+
+	spa_assert_se(mkdtemp(dir) != NULL);
+	snprintf(path, sizeof(path), "%s/benchmark.conf", dir);
+	spa_assert_se(write_config(path) == 0);
+	setenv("PIPEWIRE_CONFIG_DIR", dir, 1);
+
+	loop = pw_main_loop_new(NULL);
+	context = pw_context_new(pw_main_loop_get_loop(loop),
+			pw_properties_new(PW_KEY_CONFIG_NAME, "benchmark.conf", NULL), 0);
+	spa_assert_se(context != NULL);
+
+	run_test(context, &SPA_DICT_INIT_ARRAY(items));
+	run_test(context, &SPA_DICT_INIT(items, 2));
+
+	pw_context_destroy(context);
+	pw_main_loop_destroy(loop);
+
+	unlink(path);
+	rmdir(dir);
+
+	pw_deinit();
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+/* PipeWire */
+/* SPDX-FileCopyrightText: Copyright © 2026 PipeWire authors */
+/* SPDX-License-Identifier: MIT */
+
+#include <stdio.h>
+#include <time.h>
+
+#include <pipewire/pipewire.h>
+#include <pipewire/mem.h>
+
+#define N_LINKS		512
+#define N_BUFFERS	4
+#define BUFFER_SIZE	(8192 + 256)
+
+static const uint32_t arena_sizes[] = { 0, 256 * 1024, 4 * 1024 * 1024 };
+
+struct link {
+	struct pw_memrange *range;
+	struct pw_memblock *import;
+	struct pw_memmap *map;
+};
+
+static struct link links[N_LINKS];
+
+static uint64_t get_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return SPA_TIMESPEC_TO_NSEC(&ts);
+}
+
+static uint32_t count_blocks(struct pw_mempool *pool)
+{
+	uint32_t i, n = 0;
+	for (i = 0; i < N_LINKS; i++) {
+		if (pw_mempool_find_id(pool, i) != NULL)
+			n++;
+	}
+	return n;
+}
+
+static void run_test(uint32_t arena_size)
+{
+	struct pw_mempool *server, *client;
+	uint64_t t1, t2, t3;
+	uint32_t i, n_blocks;
+
+	server = pw_mempool_new(NULL);
+	client = pw_mempool_new(NULL);
+	spa_assert_se(server != NULL);
+	spa_assert_se(client != NULL);
+
+	pw_mempool_set_arena_size(server, arena_size);
+
+	t1 = get_time();
+	for (i = 0; i < N_LINKS; i++) {
+		struct link *l = &links[i];
+
+		/* what pw_buffers_negotiate does on the server side and what
+		 * the client does when it receives the buffers */
+		l->range = pw_mempool_alloc_range(server,
+				PW_MEMBLOCK_FLAG_READWRITE |
+				PW_MEMBLOCK_FLAG_SEAL,
+				SPA_DATA_MemFd, N_BUFFERS * BUFFER_SIZE);
+		spa_assert_se(l->range != NULL);
+
+		l->import = pw_mempool_import_block(client, l->range->block);
+		spa_assert_se(l->import != NULL);
+
+		l->map = pw_mempool_map_id(client, l->import->id,
+				PW_MEMMAP_FLAG_READWRITE,
+				l->range->offset, l->range->size, NULL);
+		spa_assert_se(l->map != NULL);
+
+		memset(l->range->ptr, i & 0xff, l->range->size);
+		spa_assert_se(((uint8_t*)l->map->ptr)[l->range->size - 1] == (i & 0xff));
+	}
+	t2 = get_time();
+
+	n_blocks = count_blocks(client);
+
+	for (i = 0; i < N_LINKS; i++) {
+		struct link *l = &links[i];
+		pw_memmap_free(l->map);
+		pw_memblock_unref(l->import);
+		pw_memrange_free(l->range);
+	}
+	t3 = get_time();
+
+	fprintf(stderr, "arena %-8u: %u links, %u fds, setup %8.3f us/link, teardown %8.3f us/link\n",
+			arena_size, N_LINKS, n_blocks,
+			(t2 - t1) / 1000.0 / N_LINKS,
+			(t3 - t2) / 1000.0 / N_LINKS);
+
+	pw_mempool_destroy(client);
+	pw_mempool_destroy(server);
+}
+
+int main(int argc, char *argv[])
+{
+	pw_init(&argc, &argv);
+
+	SPA_FOR_EACH_ELEMENT_VAR(arena_sizes, s)
+		run_test(*s);
+
+	pw_deinit();
+
+	return 0;
+}
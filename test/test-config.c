@@ -4,7 +4,10 @@
 
 #include "pwtest.h"
 
+#include <spa/utils/string.h>
+
 #include <pipewire/conf.h>
+#include <pipewire/properties.h>
 
 PWTEST(config_load_abspath)
 {
@@ -73,10 +76,44 @@ PWTEST(config_load_nullname)
 	return PWTEST_PASS;
 }
 
+static int update_props(void *data, const char *location, const char *action,
+		const char *str, size_t len)
+{
+	struct pw_properties *props = data;
+	if (spa_streq(action, "update-props"))
+		pw_properties_update_string(props, str, len);
+	return 1;
+}
+
+PWTEST(config_match_rules_update)
+{
+	/* the second rule matches the value set by the first rule */
+	const char *rules =
+		"[ { matches = [ { node.name = \"foo\" } ] "
+		"    actions = { update-props = { node.name = \"bar\" } } } "
+		"  { matches = [ { node.name = \"foo\" } ] "
+		"    actions = { update-props = { media.class = \"wrong\" } } } "
+		"  { matches = [ { node.name = \"bar\" } ] "
+		"    actions = { update-props = { node.description = \"Bar\" } } } ]";
+	struct pw_properties *props = pw_properties_new("node.name", "foo", NULL);
+	int r;
+
+	r = pw_conf_match_rules(rules, strlen(rules), "test", &props->dict,
+			update_props, props);
+	pwtest_neg_errno_ok(r);
+	pwtest_str_eq(pw_properties_get(props, "node.name"), "bar");
+	pwtest_ptr_null(pw_properties_get(props, "media.class"));
+	pwtest_str_eq(pw_properties_get(props, "node.description"), "Bar");
+	pw_properties_free(props);
+
+	return PWTEST_PASS;
+}
+
 PWTEST_SUITE(context)
 {
 	pwtest_add(config_load_abspath, PWTEST_NOARG);
 	pwtest_add(config_load_nullname, PWTEST_NOARG);
+	pwtest_add(config_match_rules_update, PWTEST_NOARG);
 
 	return PWTEST_PASS;
 }
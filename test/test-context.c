@@ -7,6 +7,7 @@
 #include <spa/utils/string.h>
 #include <spa/support/dbus.h>
 #include <spa/support/cpu.h>
+#include <spa/utils/names.h>
 
 #include <pipewire/pipewire.h>
 #include <pipewire/global.h>
@@ -259,12 +260,67 @@ PWTEST(context_support)
 	return PWTEST_PASS;
 }
 
+PWTEST(context_spa_lib)
+{
+	struct pw_main_loop *loop;
+	struct pw_context *context;
+	struct spa_handle *h1, *h2;
+	char name[64];
+	int i;
+
+	pw_init(0, NULL);
+
+	loop = pw_main_loop_new(NULL);
+	context = pw_context_new(pw_main_loop_get_loop(loop),
+			pw_properties_new(
+				PW_KEY_CONFIG_NAME, "null",
+				NULL), 0);
+	pwtest_ptr_notnull(context);
+
+	/* a lookup without library must not hide a mapping added later */
+	pwtest_ptr_null(pw_context_find_spa_lib(context, "foo.bar"));
+	pwtest_int_eq(pw_context_add_spa_lib(context, "^foo\\.", "foo/libspa-foo"), 0);
+	pwtest_str_eq(pw_context_find_spa_lib(context, "foo.bar"), "foo/libspa-foo");
+
+	/* the first matching mapping wins */
+	pwtest_int_eq(pw_context_add_spa_lib(context, "^foo\\.bar$", "bar/libspa-bar"), 0);
+	pwtest_str_eq(pw_context_find_spa_lib(context, "foo.bar"), "foo/libspa-foo");
+	pwtest_ptr_null(pw_context_find_spa_lib(context, "bar.foo"));
+
+	for (i = 0; i < 256; i++) {
+		snprintf(name, sizeof(name), "foo.%d", i);
+		pwtest_str_eq(pw_context_find_spa_lib(context, name), "foo/libspa-foo");
+	}
+	pwtest_str_eq(pw_context_find_spa_lib(context, "foo.bar"), "foo/libspa-foo");
+
+	pwtest_int_eq(pw_context_add_spa_lib(context, "^support\\.", "support/libspa-support"), 0);
+
+	/* the second handle reuses the resolved factory */
+	h1 = pw_context_load_spa_handle(context, SPA_NAME_SUPPORT_CPU, NULL);
+	pwtest_ptr_notnull(h1);
+	h2 = pw_context_load_spa_handle(context, SPA_NAME_SUPPORT_CPU, NULL);
+	pwtest_ptr_notnull(h2);
+	pwtest_ptr_ne(h1, h2);
+	pwtest_int_eq(pw_unload_spa_handle(h1), 0);
+	pwtest_int_eq(pw_unload_spa_handle(h2), 0);
+
+	pwtest_ptr_null(pw_context_load_spa_handle(context, "foo.bar", NULL));
+
+	pw_context_destroy(context);
+	pw_main_loop_destroy(loop);
+
+	pw_deinit();
+
+	return PWTEST_PASS;
+}
+
 PWTEST_SUITE(context)
 {
 	pwtest_add(context_abi, PWTEST_NOARG);
 	pwtest_add(context_create, PWTEST_NOARG);
 	pwtest_add(context_properties, PWTEST_NOARG);
 	pwtest_add(context_support, PWTEST_NOARG);
+	pwtest_add(context_spa_lib, PWTEST_NOARG);
 
 	return PWTEST_PASS;
 }
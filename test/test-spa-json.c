@@ -291,6 +291,106 @@ PWTEST(json_float_check)
 	return PWTEST_PASS;
 }
 
+PWTEST(json_float_fast)
+{
+	char buf[64], *end;
+	float v, f, r;
+	unsigned i;
+	int len;
+
+	setlocale(LC_NUMERIC, "C");
+	srand(4);
+	for (i = 0; i < 100000; i++) {
+		switch (i % 4) {
+		case 0:
+			len = snprintf(buf, sizeof(buf), "%.*g", 1 + rand() % 17,
+					(rand() - RAND_MAX / 2) * pow(10, rand() % 40 - 20) / RAND_MAX);
+			break;
+		case 1:
+			len = snprintf(buf, sizeof(buf), "%d.%0*de%d", rand() % 100000,
+					rand() % 10, rand() % 100000, rand() % 50 - 25);
+			break;
+		case 2:
+			/* halfway between two floats, needs correct rounding */
+			f = (float)rand() / RAND_MAX;
+			len = snprintf(buf, sizeof(buf), "%.17g",
+					f + (nextafterf(f, 2.0f) - f) / 2.0);
+			break;
+		default:
+			len = snprintf(buf, sizeof(buf), "%.9g", (float)rand() / (rand() + 1));
+			break;
+		}
+		r = spa_strtof(buf, &end);
+		pwtest_ptr_eq(end, buf + len);
+		pwtest_int_gt(spa_json_parse_float(buf, len, &v), 0);
+		pwtest_bool_true(memcmp(&v, &r, sizeof(v)) == 0);
+	}
+	return PWTEST_PASS;
+}
+
+static void test_tokens(const char *str, const char * const *tokens)
+{
+	struct spa_json it[2];
+	const char *value;
+	int i, len;
+
+	spa_json_init(&it[0], str, strlen(str));
+	pwtest_int_gt(spa_json_enter_array(&it[0], &it[1]), 0);
+	for (i = 0; tokens[i]; i++) {
+		pwtest_int_gt((len = spa_json_next(&it[1], &value)), 0);
+		if (spa_json_is_container(value, len))
+			len = spa_json_container_len(&it[1], value, len);
+		pwtest_int_eq(len, (int)strlen(tokens[i]));
+		pwtest_bool_true(strncmp(value, tokens[i], len) == 0);
+	}
+	pwtest_int_eq(spa_json_next(&it[1], &value), 0);
+}
+
+PWTEST(json_scan)
+{
+	/* tokens longer than the scanner block size, with the interesting
+	 * characters at different offsets */
+	test_tokens("[                                   a ]",
+			(const char *[]){ "a", NULL });
+	test_tokens("[\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\ta\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\nb ]",
+			(const char *[]){ "a", "b", NULL });
+	test_tokens("[ abcdefghijklmnopqrstuvwxyz0123456789:abcdefghijklmnopqrstuvwxyz0123456789]",
+			(const char *[]){ "abcdefghijklmnopqrstuvwxyz0123456789",
+				"abcdefghijklmnopqrstuvwxyz0123456789", NULL });
+	test_tokens("[ abcdefghijklmno\"pqrstuvwxyz{0123[45#6789, 1.2345678901234567890123456789 ]",
+			(const char *[]){ "abcdefghijklmno\"pqrstuvwxyz{0123[45#6789",
+				"1.2345678901234567890123456789", NULL });
+	test_tokens("[ \"abcdefghijklmnopqrstuvwxyz0123456789 abcdefghijklmnopqrstuvwxyz0123456789\" ]",
+			(const char *[]){ "\"abcdefghijklmnopqrstuvwxyz0123456789 abcdefghijklmnopqrstuvwxyz0123456789\"", NULL });
+	test_tokens("[ \"abcdefghijklmnopq\\\"rstuvwxyz\\\\0123456789é abcdefghijklmnopqrstuvwxyz€012345678\" ]",
+			(const char *[]){ "\"abcdefghijklmnopq\\\"rstuvwxyz\\\\0123456789é abcdefghijklmnopqrstuvwxyz€012345678\"", NULL });
+	test_tokens("[ { a = \"abcdefghijklmnopqrstuvwxyz]0123456789\" b = [ 1.0 2.0 3.0 4.0 5.0 6.0 7.0 8.0 ] } abcdefghijklmnopqrstuvwxyz ]",
+			(const char *[]){ "{ a = \"abcdefghijklmnopqrstuvwxyz]0123456789\" b = [ 1.0 2.0 3.0 4.0 5.0 6.0 7.0 8.0 ] }",
+				"abcdefghijklmnopqrstuvwxyz", NULL });
+	test_tokens("[ abcdefghijklmnopqrstuvwxyz0123456789",
+			(const char *[]){ "abcdefghijklmnopqrstuvwxyz0123456789", NULL });
+	return PWTEST_PASS;
+}
+
+PWTEST(json_scan_invalid)
+{
+	struct spa_json it;
+	const char *value;
+	const char *str[] = {
+		"\"abcdefghijklmnopqrstuvwxyz0123456789\x01\"",
+		"\"abcdefghijklmnopqrstuvwxyz0123456789\x7f\"",
+		"\"abcdefghijklmnopqrstuvwxyz0123456789\xff\"",
+		"\"abcdefghijklmnopqrstuvwxyz0123456789\\q\"",
+	};
+	unsigned i;
+
+	for (i = 0; i < SPA_N_ELEMENTS(str); i++) {
+		spa_json_init(&it, str[i], strlen(str[i]));
+		pwtest_int_lt(spa_json_next(&it, &value), 0);
+	}
+	return PWTEST_PASS;
+}
+
 PWTEST(json_int)
 {
 	int v;
@@ -307,6 +407,9 @@ PWTEST_SUITE(spa_json)
 	pwtest_add(json_overflow, PWTEST_NOARG);
 	pwtest_add(json_float, PWTEST_NOARG);
 	pwtest_add(json_float_check, PWTEST_NOARG);
+	pwtest_add(json_float_fast, PWTEST_NOARG);
+	pwtest_add(json_scan, PWTEST_NOARG);
+	pwtest_add(json_scan_invalid, PWTEST_NOARG);
 	pwtest_add(json_int, PWTEST_NOARG);
 
 	return PWTEST_PASS;
@@ -6,11 +6,13 @@
 #include <spa/pod/builder.h>
 #include <spa/pod/command.h>
 #include <spa/pod/event.h>
+#include <spa/pod/filter.h>
 #include <spa/pod/iter.h>
 #include <spa/pod/parser.h>
 #include <spa/pod/vararg.h>
 #include <spa/debug/pod.h>
 #include <spa/param/format.h>
+#include <spa/param/audio/raw.h>
 #include <spa/param/video/raw.h>
 #include <spa/utils/string.h>
 
@@ -1668,6 +1670,130 @@ PWTEST(pod_overflow2)
 	return PWTEST_PASS;
 }
 
+static void check_filter_index(const struct spa_pod *pod, const struct spa_pod *filter)
+{
+	uint8_t buf1[4096], buf2[4096];
+	struct spa_pod_builder b1, b2;
+	struct spa_pod_index ipod, ifilter;
+	struct spa_pod *r1 = NULL, *r2 = NULL;
+	int res1, res2;
+
+	spa_pod_builder_init(&b1, buf1, sizeof(buf1));
+	spa_pod_builder_init(&b2, buf2, sizeof(buf2));
+
+	spa_assert_se(spa_pod_index_init(&ipod, pod) == 0);
+	spa_assert_se(spa_pod_index_init(&ifilter, filter) == 0);
+
+	res1 = spa_pod_filter(&b1, &r1, pod, filter);
+	res2 = spa_pod_filter_index(&b2, &r2, &ipod, &ifilter);
+	spa_assert_se(res1 == res2);
+	if (res1 >= 0) {
+		spa_assert_se(SPA_POD_SIZE(r1) == SPA_POD_SIZE(r2));
+		spa_assert_se(memcmp(r1, r2, SPA_POD_SIZE(r1)) == 0);
+	} else {
+		spa_assert_se(b2.state.offset == 0);
+	}
+}
+
+PWTEST(pod_filter_index)
+{
+	uint8_t buffer[4096];
+	struct spa_pod_builder b;
+	struct spa_pod *audio1, *audio2, *audio3, *video1, *video2, *unsorted;
+	struct spa_pod_index index;
+	struct spa_pod_int pi = SPA_POD_INIT_Int(1);
+	struct spa_pod_frame f;
+
+	spa_pod_builder_init(&b, buffer, sizeof(buffer));
+
+	audio1 = spa_pod_builder_add_object(&b,
+			SPA_TYPE_OBJECT_Format, SPA_PARAM_EnumFormat,
+			SPA_FORMAT_mediaType,      SPA_POD_Id(SPA_MEDIA_TYPE_audio),
+			SPA_FORMAT_mediaSubtype,   SPA_POD_Id(SPA_MEDIA_SUBTYPE_raw),
+			SPA_FORMAT_AUDIO_format,   SPA_POD_CHOICE_ENUM_Id(4,
+							SPA_AUDIO_FORMAT_F32P,
+							SPA_AUDIO_FORMAT_F32P,
+							SPA_AUDIO_FORMAT_S16,
+							SPA_AUDIO_FORMAT_S32),
+			SPA_FORMAT_AUDIO_rate,     SPA_POD_CHOICE_RANGE_Int(48000, 1, INT32_MAX),
+			SPA_FORMAT_AUDIO_channels, SPA_POD_CHOICE_RANGE_Int(2, 1, 64));
+	audio2 = spa_pod_builder_add_object(&b,
+			SPA_TYPE_OBJECT_Format, SPA_PARAM_EnumFormat,
+			SPA_FORMAT_mediaType,      SPA_POD_Id(SPA_MEDIA_TYPE_audio),
+			SPA_FORMAT_mediaSubtype,   SPA_POD_Id(SPA_MEDIA_SUBTYPE_raw),
+			SPA_FORMAT_AUDIO_format,   SPA_POD_CHOICE_ENUM_Id(3,
+							SPA_AUDIO_FORMAT_S32,
+							SPA_AUDIO_FORMAT_S16,
+							SPA_AUDIO_FORMAT_S32),
+			SPA_FORMAT_AUDIO_rate,     SPA_POD_CHOICE_ENUM_Int(3, 44100, 44100, 48000),
+			SPA_FORMAT_AUDIO_channels, SPA_POD_Int(2));
+	audio3 = spa_pod_builder_add_object(&b,
+			SPA_TYPE_OBJECT_Format, SPA_PARAM_EnumFormat,
+			SPA_FORMAT_mediaType,      SPA_POD_Id(SPA_MEDIA_TYPE_audio),
+			SPA_FORMAT_mediaSubtype,   SPA_POD_Id(SPA_MEDIA_SUBTYPE_raw),
+			SPA_FORMAT_AUDIO_format,   SPA_POD_Id(SPA_AUDIO_FORMAT_U8),
+			SPA_FORMAT_AUDIO_rate,     SPA_POD_Int(22050));
+	video1 = spa_pod_builder_add_object(&b,
+			SPA_TYPE_OBJECT_Format, SPA_PARAM_EnumFormat,
+			SPA_FORMAT_mediaType,	    SPA_POD_Id(SPA_MEDIA_TYPE_video),
+			SPA_FORMAT_mediaSubtype,    SPA_POD_Id(SPA_MEDIA_SUBTYPE_raw),
+			SPA_FORMAT_VIDEO_format,    SPA_POD_CHOICE_ENUM_Id(3,
+							SPA_VIDEO_FORMAT_I420,
+							SPA_VIDEO_FORMAT_I420,
+							SPA_VIDEO_FORMAT_YUY2),
+			SPA_FORMAT_VIDEO_size,      SPA_POD_CHOICE_RANGE_Rectangle(
+							&SPA_RECTANGLE(320, 240),
+							&SPA_RECTANGLE(1, 1),
+							&SPA_RECTANGLE(INT32_MAX, INT32_MAX)),
+			SPA_FORMAT_VIDEO_framerate, SPA_POD_CHOICE_RANGE_Fraction(
+							&SPA_FRACTION(25,1),
+							&SPA_FRACTION(0,1),
+							&SPA_FRACTION(INT32_MAX,1)));
+	video2 = spa_pod_builder_add_object(&b,
+			SPA_TYPE_OBJECT_Format, SPA_PARAM_EnumFormat,
+			SPA_FORMAT_mediaType,	    SPA_POD_Id(SPA_MEDIA_TYPE_video),
+			SPA_FORMAT_mediaSubtype,    SPA_POD_Id(SPA_MEDIA_SUBTYPE_raw),
+			SPA_FORMAT_VIDEO_format,    SPA_POD_Id(SPA_VIDEO_FORMAT_YUY2),
+			SPA_FORMAT_VIDEO_size,      SPA_POD_CHOICE_RANGE_Rectangle(
+							&SPA_RECTANGLE(640, 480),
+							&SPA_RECTANGLE(320, 240),
+							&SPA_RECTANGLE(1920, 1080)),
+			SPA_FORMAT_VIDEO_framerate, SPA_POD_CHOICE_ENUM_Fraction(3,
+							&SPA_FRACTION(30,1),
+							&SPA_FRACTION(30,1),
+							&SPA_FRACTION(60,1)));
+
+	/* keys out of order and a mandatory property */
+	spa_pod_builder_push_object(&b, &f, SPA_TYPE_OBJECT_Format, SPA_PARAM_EnumFormat);
+	spa_pod_builder_add(&b,
+			SPA_FORMAT_AUDIO_channels, SPA_POD_Int(2),
+			SPA_FORMAT_mediaSubtype,   SPA_POD_Id(SPA_MEDIA_SUBTYPE_raw),
+			SPA_FORMAT_mediaType,      SPA_POD_Id(SPA_MEDIA_TYPE_audio),
+			0);
+	spa_pod_builder_prop(&b, SPA_FORMAT_AUDIO_position, SPA_POD_PROP_FLAG_MANDATORY);
+	spa_pod_builder_id(&b, SPA_AUDIO_CHANNEL_FL);
+	unsorted = spa_pod_builder_pop(&b, &f);
+
+	spa_assert_se(spa_pod_index_init(&index, unsorted) == 0);
+	spa_assert_se(index.n_props == 4);
+	spa_assert_se(spa_pod_index_find(&index, SPA_FORMAT_mediaType) == &index.props[2]);
+	spa_assert_se(spa_pod_index_find(&index, SPA_FORMAT_AUDIO_channels) == &index.props[0]);
+	spa_assert_se(spa_pod_index_find(&index, SPA_FORMAT_AUDIO_rate) == NULL);
+	spa_assert_se(spa_pod_index_init(&index, &pi.pod) == -EINVAL);
+
+	check_filter_index(audio1, audio2);
+	check_filter_index(audio2, audio1);
+	check_filter_index(audio1, audio3);
+	check_filter_index(audio3, audio2);
+	check_filter_index(audio1, unsorted);
+	check_filter_index(unsorted, audio2);
+	check_filter_index(video1, video2);
+	check_filter_index(video2, video1);
+	check_filter_index(video1, audio1);
+
+	return PWTEST_PASS;
+}
+
 PWTEST_SUITE(spa_pod)
 {
 	pwtest_add(pod_abi_sizes, PWTEST_NOARG);
@@ -1682,6 +1808,7 @@ PWTEST_SUITE(spa_pod)
 	pwtest_add(pod_static, PWTEST_NOARG);
 	pwtest_add(pod_overflow, PWTEST_NOARG);
 	pwtest_add(pod_overflow2, PWTEST_NOARG);
+	pwtest_add(pod_filter_index, PWTEST_NOARG);
 
 	return PWTEST_PASS;
 }